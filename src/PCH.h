@@ -1,7 +1,10 @@
 #pragma once
 
+#include <bit>
 #include <cmath>
 #include <mutex>
+#include <optional>
+#include <shared_mutex>
 #include <thread>
 #include <typeinfo>
 
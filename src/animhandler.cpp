@@ -1,42 +1,44 @@
 #include "animhandler.hpp"
 
 #include "formutil.hpp"
+#include "h2hlevel.hpp"
 #include "logger.hpp"
+#include "maintask.hpp"
+#include "sinkregistry.hpp"
 
 using bhh_events::AnimHandler;
-using std::chrono::duration_cast;
-using std::chrono::milliseconds;
+using bhh_events::SinkRegistry;
 using std::chrono::steady_clock;
 
-static RE::PlayerCharacter* player;
+using AnimSink = RE::BSTEventSink<RE::BSAnimationGraphEvent>;
+using CombatSink = RE::BSTEventSink<RE::TESCombatEvent>;
+using DeathSink = RE::BSTEventSink<RE::TESDeathEvent>;
+using CellSink = RE::BSTEventSink<RE::TESCellAttachDetachEvent>;
 
-struct {
-    // This appears to be the animation tag used by all attack start animations.
-    // Does not play on repeated attack strings
-    static constexpr auto attackStart = "PowerAttack_Start_end";
-
-    // This appears to only occur once! even in combo attacks.
-    // This is a suitable since its seems like the best event to catch exactly one attack input.
-    static constexpr auto preHitFrame = "preHitFrame";
-
-    // These one show up when a player spams a light attack
-    static constexpr auto attackFollow = "AttackWinStart";
-    static constexpr auto attackFollowLeft = "AttackWinStartLeft";
-
-    // This sems to be the only power attack unique anim tag
-    static constexpr auto powerAttackEnd = "PowerAttackStop";
-
-    // Happens at end of all attacks
-    static constexpr auto attackStop = "attackStop";
-} animTags;
-struct {
-    // These appear to the the Attack Event data associated with the different possible hand to hand attacks
-    static constexpr auto rightAttack = "AttackStartH2HRight";
-    static constexpr auto rightPowerAttack = "attackPowerStartForwardH2HRightHand";
-    static constexpr auto leftAttack = "AttackStartH2HLeft";
-    static constexpr auto leftPowerAttack = "attackPowerStartForwardH2HLeftHand";
-    static constexpr auto comboPowerAttack = "attackPowerStartH2HCombo";
-} events;
+// Vanilla doesn't keep editor IDs for factions, so the plugin and local form ID from the ini are the reliable lookup.
+// The editor ID fallback only works with something that keeps them loaded, like powerofthree's Tweaks.
+RE::TESFaction* findRotateFaction(const char* editorId) {
+    auto const& settings = h2h_level::Settings;
+    if (!settings.RotateFactionPlugin.empty() && settings.RotateFactionFormID != 0) {
+        auto dataHandler = RE::TESDataHandler::GetSingleton();
+        auto found = dataHandler ? dataHandler->LookupForm<RE::TESFaction>(settings.RotateFactionFormID,
+                                                                             settings.RotateFactionPlugin)
+                                 : nullptr;
+        if (found == nullptr) {
+            logger::warn("No faction 0x{:x} in {}, attack rotation is player only.", settings.RotateFactionFormID,
+                         settings.RotateFactionPlugin);
+        }
+        return found;
+    }
+    auto found = RE::TESForm::LookupByEditorID<RE::TESFaction>(editorId);
+    if (found == nullptr) {
+        logger::warn(
+            "{} not found by editor ID, attack rotation is player only. Set FactionPlugin and FactionFormID under "
+            "[NPCRotation] in the ini to rotate NPC attacks.",
+            editorId);
+    }
+    return found;
+}
 
 AnimHandler* AnimHandler::GetSingleton() {
     static AnimHandler singleton{};
@@ -44,7 +46,7 @@ AnimHandler* AnimHandler::GetSingleton() {
 }
 
 bool AnimHandler::Register() {
-    player = RE::PlayerCharacter::GetSingleton();
+    auto player = RE::PlayerCharacter::GetSingleton();
     if (player == nullptr) {
         logger::error("Failed to load player pointer");
         return false;
@@ -56,17 +58,136 @@ bool AnimHandler::Register() {
     // Get Unarmed weapon keyword
     if (!initFormFromEditorId(handler->keyword.unarmedWeapKeywordId, handler->keyword.unarmedKeyword)) return false;
 
-    if (!player->AddAnimationGraphEventSink(handler)) {
-        logger::error("Failed to register AnimationGraphEvent event");
+    handler->faction.rotateAttack = findRotateFaction(handler->faction.rotateAttackId);
+    if (handler->faction.rotateAttack != nullptr) {
+        auto eventHolder = RE::ScriptEventSourceHolder::GetSingleton();
+        if (eventHolder != nullptr) {
+            // Not session scoped, the registry keeps these to a single attachment across loads.
+            auto registry = SinkRegistry::GetSingleton();
+            registry->Attach("AnimHandlerCombat", static_cast<CombatSink*>(handler),
+                             eventHolder->GetEventSource<RE::TESCombatEvent>(), false);
+            registry->Attach("AnimHandlerDeath", static_cast<DeathSink*>(handler),
+                             eventHolder->GetEventSource<RE::TESDeathEvent>(), false);
+            registry->Attach("AnimHandlerCellDetach", static_cast<CellSink*>(handler),
+                             eventHolder->GetEventSource<RE::TESCellAttachDetachEvent>(), false);
+        }
+    }
+    return handler->track(player);
+}
+
+void AnimHandler::ResetSession() {
+    LOGTRACE("Forgetting {} tracked actors.", actors.Size());
+    actors.Clear();
+}
+
+bool AnimHandler::track(RE::Actor* actor) {
+    auto rotation = 1.0f;
+    if (actor->IsPlayerRef()) {
+        rotation = glob.rotateAttack->value < 0.0f ? -1.0f : 1.0f;
+    }
+    if (!actors.Track(actor->GetFormID(), actor->GetHandle(), actor, rotation) &&
+        (evictStale() == 0 || !actors.Track(actor->GetFormID(), actor->GetHandle(), actor, rotation))) {
+        logger::warn("Actor table full, not rotating attacks for 0x{:x}.", actor->GetFormID());
+        return false;
+    }
+    // Session scoped, the registry drops these on load so each fresh graph gets exactly one sink.
+    if (!SinkRegistry::GetSingleton()->AttachAnimationGraph("AnimHandler", this, actor, true)) {
+        actors.Untrack(actor->GetFormID());
         return false;
     }
-    logger::info("AnimationGraphEvent event Registered");
     return true;
 }
 
+void AnimHandler::untrack(RE::Actor* actor) {
+    SinkRegistry::GetSingleton()->Detach(static_cast<AnimSink*>(this), actor);
+    if (auto entry = actors.Untrack(actor->GetFormID()); entry && entry->toggled) {
+        queueRank(entry->handle, -1);
+    }
+}
+
+std::size_t AnimHandler::evictStale() {
+    struct Evicted {
+        const RE::Actor* graphSource;
+        RE::ActorHandle handle;
+        bool toggled;
+    };
+    std::array<Evicted, maxEvictions> evicted{};
+    std::size_t count = 0;
+    actors.EraseIf([&evicted, &count](RE::FormID, RotationTable::Entry& entry) {
+        if (count == evicted.size()) {
+            return false;
+        }
+        auto actor = entry.handle.get();
+        if (actor && (actor->IsPlayerRef() || (!actor->IsDead() && actor->IsInCombat()))) {
+            return false;
+        }
+        evicted[count++] = {entry.graphSource, entry.handle, entry.toggled};
+        return true;
+    });
+    // Outside the table lock, detaching can wait on a graph that is dispatching to us.
+    for (std::size_t i = 0; i < count; ++i) {
+        SinkRegistry::GetSingleton()->Detach(static_cast<AnimSink*>(this), evicted[i].graphSource);
+        if (evicted[i].toggled) {
+            queueRank(evicted[i].handle, -1);
+        }
+    }
+    logger::info("Actor table full, evicted {} stale actors.", count);
+    return count;
+}
+
+RE::BSEventNotifyControl AnimHandler::ProcessEvent(const RE::TESCombatEvent* event,
+                                                   RE::BSTEventSource<RE::TESCombatEvent>*) {
+    SinkRegistry::GetSingleton()->RecordDispatch(static_cast<CombatSink*>(this));
+    if (event == nullptr || !event->actor) {
+        return RE::BSEventNotifyControl::kContinue;
+    }
+    auto actor = event->actor->As<RE::Actor>();
+    if (actor == nullptr || actor->IsPlayerRef()) {
+        return RE::BSEventNotifyControl::kContinue;
+    }
+    switch (event->newState.get()) {
+    case RE::ACTOR_COMBAT_STATE::kCombat:
+        track(actor);
+        break;
+    case RE::ACTOR_COMBAT_STATE::kNone:
+        untrack(actor);
+        break;
+    default:
+        // Still searching for a target, keep tracking.
+        break;
+    }
+    return RE::BSEventNotifyControl::kContinue;
+}
+
+RE::BSEventNotifyControl AnimHandler::ProcessEvent(const RE::TESDeathEvent* event,
+                                                   RE::BSTEventSource<RE::TESDeathEvent>*) {
+    SinkRegistry::GetSingleton()->RecordDispatch(static_cast<DeathSink*>(this));
+    if (event == nullptr || !event->actorDying) {
+        return RE::BSEventNotifyControl::kContinue;
+    }
+    auto actor = event->actorDying->As<RE::Actor>();
+    if (actor != nullptr && !actor->IsPlayerRef()) {
+        untrack(actor);
+    }
+    return RE::BSEventNotifyControl::kContinue;
+}
+
+RE::BSEventNotifyControl AnimHandler::ProcessEvent(const RE::TESCellAttachDetachEvent* event,
+                                                   RE::BSTEventSource<RE::TESCellAttachDetachEvent>*) {
+    SinkRegistry::GetSingleton()->RecordDispatch(static_cast<CellSink*>(this));
+    if (event == nullptr || event->attached || !event->reference) {
+        return RE::BSEventNotifyControl::kContinue;
+    }
+    auto actor = event->reference->As<RE::Actor>();
+    if (actor != nullptr && !actor->IsPlayerRef()) {
+        untrack(actor);
+    }
+    return RE::BSEventNotifyControl::kContinue;
+}
+
 // Check if hand to hand is in both hands. Null weapon is normal hand to hand.
-bool H2HEquiped(RE::BGSKeyword* const unarmedKeyword) {
-    auto weapForm = player->GetEquippedObject(false);
+bool H2HEquiped(RE::Actor* actor, RE::BGSKeyword* const unarmedKeyword) {
+    auto weapForm = actor->GetEquippedObject(false);
     if (weapForm != nullptr) {
         auto weap = weapForm->As<RE::TESObjectWEAP>();
         if (weap != nullptr && !weap->HasKeyword(unarmedKeyword)) {
@@ -74,7 +195,7 @@ bool H2HEquiped(RE::BGSKeyword* const unarmedKeyword) {
             return false;
         }
     }
-    weapForm = player->GetEquippedObject(true);
+    weapForm = actor->GetEquippedObject(true);
     if (weapForm != nullptr) {
         auto weap = weapForm->As<RE::TESObjectWEAP>();
         if (weap != nullptr && !weap->HasKeyword(unarmedKeyword)) {
@@ -92,24 +213,31 @@ bool AnimHandler::isToggleOn() const {
 
 RE::BSEventNotifyControl AnimHandler::ProcessEvent(const RE::BSAnimationGraphEvent* event,
                                                    RE::BSTEventSource<RE::BSAnimationGraphEvent>*) {
-    static std::chrono::time_point<steady_clock> lastToggleTime;
-    static const auto minWait = milliseconds(400);
-    if (!isToggleOn() || !H2HEquiped(keyword.unarmedKeyword)) {
+    SinkRegistry::GetSingleton()->RecordDispatch(static_cast<AnimSink*>(this));
+    if (event == nullptr || event->holder == nullptr || !isToggleOn()) {
+        return RE::BSEventNotifyControl::kContinue;
+    }
+    auto actor = const_cast<RE::TESObjectREFR*>(event->holder)->As<RE::Actor>();
+    if (actor == nullptr) {
         return RE::BSEventNotifyControl::kContinue;
     }
+    auto const formId = actor->GetFormID();
     auto now = steady_clock::now();
-    if (duration_cast<milliseconds>(now - lastToggleTime) < minWait) {
+    if (!actors.WantsEvent(formId, now)) {
+        return RE::BSEventNotifyControl::kContinue;
+    }
+    if (!H2HEquiped(actor, keyword.unarmedKeyword)) {
         return RE::BSEventNotifyControl::kContinue;
     }
 
-    auto playerProcess = player->GetActorRuntimeData().currentProcess;
-    if (playerProcess == nullptr) {
-        logger::error("null player process data");
+    auto actorProcess = actor->GetActorRuntimeData().currentProcess;
+    if (actorProcess == nullptr) {
+        LOGTRACE("null process data for 0x{:x}", formId);
         return RE::BSEventNotifyControl::kContinue;
     }
-    auto hiProcess = playerProcess->high;
+    auto hiProcess = actorProcess->high;
     if (hiProcess == nullptr) {
-        logger::error("null high process data for player");
+        LOGTRACE("null high process data for 0x{:x}", formId);
         return RE::BSEventNotifyControl::kContinue;
     }
     auto attackData = hiProcess->attackData;
@@ -118,39 +246,47 @@ RE::BSEventNotifyControl AnimHandler::ProcessEvent(const RE::BSAnimationGraphEve
         return RE::BSEventNotifyControl::kContinue;
     }
     bool isPower = static_cast<bool>(attackData->data.flags & RE::AttackData::AttackFlag::kPowerAttack);
-    std::string const tag{event->tag.data()}, attackEvent{attackData->event.c_str()};
-
-    if (attackEvent != events.comboPowerAttack &&     // Dont toggle on power combo
-        (tag.rfind(animTags.attackFollow, 0) == 0 ||  // Toggle on combo hits or...
-         tag.rfind(animTags.attackStop, 0) == 0)) {   // toggle on attack stoping all together
-        LOGTRACE("animEventTag {}, attackEvent {}, attack isPower {}", tag, attackEvent, isPower);
-        applyToggle(attackEvent, isPower);
-        lastToggleTime = now;
+    // Views over the fixed strings, this runs for every animation event so don't copy them.
+    std::string_view const tag{event->tag.c_str()}, attackEvent{attackData->event.c_str()};
+    LOGTRACE("animEventTag {}, attackEvent {}, attack isPower {}", tag, attackEvent, isPower);
+    auto rotation = actors.Toggle(formId, tag, attackEvent, isPower, now);
+    if (rotation == 0.0f) {
+        return RE::BSEventNotifyControl::kContinue;
     }
+    applyToggle(actor, rotation);
     return RE::BSEventNotifyControl::kContinue;
 }
 
-void AnimHandler::applyToggle(std::string const& attackEvent, bool isPower) {
+void AnimHandler::applyToggle(RE::Actor* actor, float rotation) {
     LOGTRACE("Applying toggle");
-    if (isPower) {
-        if (attackEvent == events.rightPowerAttack) {
-            glob.rotateAttack->value = -1.0f;
-            return;
-        }
-        if (attackEvent == events.leftPowerAttack) {
-            glob.rotateAttack->value = 1.0f;
-            return;
-        }
-    } else {
-        if (attackEvent == events.rightAttack) {
-            glob.rotateAttack->value = -1.0f;
-            return;
-        }
-        if (attackEvent == events.leftAttack) {
-            glob.rotateAttack->value = 1.0f;
-            return;
-        }
+    if (actor->IsPlayerRef()) {
+        glob.rotateAttack->value = rotation;
+        return;
+    }
+    // Rank 1 stands in for the global's 1 and rank 0 for its -1.
+    queueRank(actor->GetHandle(), static_cast<std::int8_t>(rotation > 0.0f ? 1 : 0));
+}
+
+void AnimHandler::queueRank(RE::ActorHandle actor, std::int8_t rank) {
+    if (faction.rotateAttack == nullptr) {
+        return;
+    }
+    // Faction changes aren't safe from the animation threads, hand them to the main thread. One task for joining and
+    // leaving keeps them in order.
+    static MainThreadTask<RankUpdate, 64> rankTask("NPC attack rotation", applyRank);
+    rankTask.Push({actor, faction.rotateAttack, rank});
+}
+
+void AnimHandler::applyRank(RankUpdate& update) {
+    auto npc = update.actor.get();
+    if (!npc) {
+        return;
+    }
+    // A toggle that raced the NPC leaving mustn't put it back in once the removal has run.
+    if (update.rank >= 0 && !GetSingleton()->actors.IsTracked(npc->GetFormID())) {
+        return;
     }
-    LOGTRACE("No case reached?");
-    LOGTRACE("Event {}, Atatck Toggle: {}", attackEvent, glob.rotateAttack->value);
+    // Rank -1 is the game's own "not a member", the same thing Actor.RemoveFromFaction leaves behind. Nothing of the
+    // rotation stays with the NPC once it's out of combat.
+    npc->AddToFaction(update.faction, update.rank);
 }
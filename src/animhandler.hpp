@@ -1,15 +1,34 @@
 #pragma once
 #include "RE/Skyrim.h"
+#include "rotationtable.hpp"
 
 namespace bhh_events {
 
-    class AnimHandler : public RE::BSTEventSink<RE::BSAnimationGraphEvent> {
+    /*
+     * One shared animation graph sink that rotates hand to hand attacks for every tracked actor.
+     * The player is always tracked and rotates through the BHH_RotateAttacks global. NPCs are tracked while in combat
+     * and rotate through their rank in BHH_RotateAttacksFaction, when that faction exists. They stop being tracked
+     * and leave the faction when they leave combat, die or unload.
+     */
+    class AnimHandler : public RE::BSTEventSink<RE::BSAnimationGraphEvent>,
+                        public RE::BSTEventSink<RE::TESCombatEvent>,
+                        public RE::BSTEventSink<RE::TESDeathEvent>,
+                        public RE::BSTEventSink<RE::TESCellAttachDetachEvent> {
     public:
         static AnimHandler* GetSingleton();
         static bool Register();
 
         RE::BSEventNotifyControl ProcessEvent(const RE::BSAnimationGraphEvent* a_event,
                                               RE::BSTEventSource<RE::BSAnimationGraphEvent>* a_eventSource) override;
+        RE::BSEventNotifyControl ProcessEvent(const RE::TESCombatEvent* a_event,
+                                              RE::BSTEventSource<RE::TESCombatEvent>* a_eventSource) override;
+        RE::BSEventNotifyControl ProcessEvent(const RE::TESDeathEvent* a_event,
+                                              RE::BSTEventSource<RE::TESDeathEvent>* a_eventSource) override;
+        RE::BSEventNotifyControl ProcessEvent(const RE::TESCellAttachDetachEvent* a_event,
+                                              RE::BSTEventSource<RE::TESCellAttachDetachEvent>* a_eventSource) override;
+
+        // Forgets tracked actors. Their graph sinks are detached by the sink registry.
+        void ResetSession();
 
     private:
         AnimHandler() = default;
@@ -23,7 +42,31 @@ namespace bhh_events {
             static constexpr auto unarmedWeapKeywordId = "BHH_WeapTypeUnarmed";
             RE::BGSKeyword* unarmedKeyword;
         } keyword;
+        struct {
+            // Optional, NPC attack rotation is off without it.
+            static constexpr auto rotateAttackId = "BHH_RotateAttacksFaction";
+            RE::TESFaction* rotateAttack;
+        } faction;
+
+        // Most stale entries dropped in one sweep when the table fills up.
+        static constexpr std::size_t maxEvictions = 32;
+        RotationTable actors;
+
+        // NPC faction rank changes waiting for the main thread.
+        struct RankUpdate {
+            RE::ActorHandle actor;
+            RE::TESFaction* faction;
+            std::int8_t rank;
+        };
+
         bool isToggleOn() const;
-        void applyToggle(std::string const& attackEvent, bool isPower);
+        bool track(RE::Actor* actor);
+        void untrack(RE::Actor* actor);
+        // Drops entries for NPCs that are gone or out of combat without an event saying so. Returns how many went.
+        std::size_t evictStale();
+        void applyToggle(RE::Actor* actor, float rotation);
+        // Hands a faction rank change to the main thread. Rank -1 takes the NPC back out of the faction.
+        void queueRank(RE::ActorHandle actor, std::int8_t rank);
+        static void applyRank(RankUpdate& update);
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include "RE/Skyrim.h"
+
+namespace bhh_events {
+    /*
+     * Fixed capacity FormID keyed hash table with linear probing. Slots are inline so lookups touch one or two cache
+     * lines and nothing is ever allocated. Erase shifts later entries back instead of leaving tombstones.
+     * Not thread safe on its own, guard it with the owner's lock.
+     */
+    template <class T, std::size_t N>
+    class FormIDTable {
+        static_assert(std::has_single_bit(N), "FormIDTable capacity must be a power of two");
+
+    public:
+        // Inserts stop at this many entries to keep probe runs short.
+        static constexpr std::size_t maxEntries = N / 4 * 3;
+
+        T* Find(RE::FormID formId) {
+            if (formId == 0) {
+                return nullptr;
+            }
+            for (auto i = home(formId);; i = next(i)) {
+                if (slots[i].formId == formId) {
+                    return &slots[i].value;
+                }
+                if (slots[i].formId == 0) {
+                    return nullptr;
+                }
+            }
+        }
+
+        // Returns the existing entry or a default constructed new one. Null if full.
+        T* Insert(RE::FormID formId) {
+            if (formId == 0) {
+                return nullptr;
+            }
+            auto i = home(formId);
+            for (; slots[i].formId != 0; i = next(i)) {
+                if (slots[i].formId == formId) {
+                    return &slots[i].value;
+                }
+            }
+            if (count >= maxEntries) {
+                return nullptr;
+            }
+            slots[i].formId = formId;
+            slots[i].value = T{};
+            ++count;
+            return &slots[i].value;
+        }
+
+        bool Erase(RE::FormID formId) {
+            if (formId == 0) {
+                return false;
+            }
+            auto i = home(formId);
+            for (; slots[i].formId != formId; i = next(i)) {
+                if (slots[i].formId == 0) {
+                    return false;
+                }
+            }
+            // Pull back any later entry in the run whose home slot isn't between the hole and itself.
+            for (auto j = next(i); slots[j].formId != 0; j = next(j)) {
+                auto k = home(slots[j].formId);
+                bool movable = i <= j ? (k <= i || k > j) : (k <= i && k > j);
+                if (movable) {
+                    slots[i] = slots[j];
+                    i = j;
+                }
+            }
+            slots[i] = Slot{};
+            --count;
+            return true;
+        }
+
+        // Erases every entry pred(formId, value) returns true for. Returns how many went.
+        template <class Pred>
+        std::size_t EraseIf(Pred&& pred) {
+            std::size_t erased = 0;
+            for (std::size_t i = 0; i < N;) {
+                // Erase may shift a later entry into this slot, so look at it again before moving on.
+                if (slots[i].formId != 0 && pred(slots[i].formId, slots[i].value)) {
+                    Erase(slots[i].formId);
+                    ++erased;
+                } else {
+                    ++i;
+                }
+            }
+            return erased;
+        }
+
+        void Clear() {
+            slots.fill(Slot{});
+            count = 0;
+        }
+
+        std::size_t Size() const { return count; }
+
+    private:
+        struct Slot {
+            RE::FormID formId = 0;
+            T value{};
+        };
+
+        static std::size_t home(RE::FormID formId) {
+            auto hash = static_cast<std::uint32_t>(formId * 2654435761u);
+            return (hash ^ (hash >> 16)) & (N - 1);
+        }
+        static std::size_t next(std::size_t i) { return (i + 1) & (N - 1); }
+
+        std::array<Slot, N> slots{};
+        std::size_t count = 0;
+    };
+}
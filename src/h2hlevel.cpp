@@ -5,7 +5,9 @@
 #include "RE/Skyrim.h"
 #include "formutil.hpp"
 #include "logger.hpp"
+#include "maintask.hpp"
 #include "scriputil.hpp"
+#include "sinkregistry.hpp"
 
 using h2h_level::Settings;
 using h2h_level::StartingSkillManager;
@@ -32,52 +34,203 @@ void h2h_level::LoadSettingsINI() {
     loadSettingVal(xpSection, ini, Settings.SkillImproveMult);
     loadSettingVal(xpSection, ini, Settings.SkillImproveOffset);
     loadSettingVal(xpSection, ini, Settings.DamageXPDampen);
+    auto constexpr drSection = "DiminishingReturns";
+    loadSettingVal(drSection, ini, Settings.DRCapacity);
+    loadSettingVal(drSection, ini, Settings.DRHalfLife);
+    loadSettingVal(drSection, ini, Settings.DRPenaltyPerHit);
+    loadSettingVal(drSection, ini, Settings.DRMinMultiplier);
+    auto constexpr dedupeSection = "HitDedupe";
+    loadSettingVal(dedupeSection, ini, Settings.DedupeWindowMs);
+    loadSettingVal(dedupeSection, ini, Settings.DedupeSliding);
+    loadSettingVal("PlayerXP", ini, Settings.NativePlayerXP);
+    auto constexpr npcSection = "NPCRotation";
+    Settings.RotateFactionPlugin = ini.GetValue(npcSection, "FactionPlugin", "");
+    Settings.RotateFactionFormID = h2h_level::ParseFormID(ini.GetValue(npcSection, "FactionFormID", ""));
+    logger::info("Setting {}.FactionPlugin set to {}, FactionFormID to 0x{:x}", npcSection,
+                 Settings.RotateFactionPlugin, Settings.RotateFactionFormID);
     logger::info("Finished loading XP settings from ini.");
 }
 
-float h2h_level::nextSkillLevelXP(float currentLevel, float xpSkillCurve) {
-    return Settings.SkillImproveMult.value * powf(currentLevel, xpSkillCurve) + Settings.SkillImproveOffset.value;
-}
+namespace {
+    using CallbackPtr = RE::BSTSmartPointer<RE::BSScript::IStackCallbackFunctor>;
 
-float h2h_level::calcSkillXpGain(float damage) {
-    return Settings.SkillUseMult.value * powf(damage, Settings.DamageXPDampen.value) + Settings.SkillUseOffset.value;
-}
+    // Hands back the pooled callback ready for another dispatch, creating it the first time.
+    template <class Functor, class... Args>
+    Functor* acquireCallback(CallbackPtr& pooled, Args&&... args) {
+        auto functor = static_cast<Functor*>(pooled.get());
+        if (functor == nullptr) {
+            functor = new Functor(std::forward<Args>(args)...);
+            pooled = CallbackPtr(functor);
+        } else {
+            functor->Reset();
+        }
+        return functor;
+    }
 
-void h2h_level::GivePlayerXP(float xpGained) {
-    static std::mutex xpFuncMutex;
-    static auto papyrusVM = RE::BSScript::Internal::VirtualMachine::GetSingleton();
-    static auto player = RE::PlayerCharacter::GetSingleton();
-
-    std::lock_guard<std::mutex> guard(xpFuncMutex);
-    LOGTRACE("Processing player level xp of {}.", xpGained);
-
-    // Dispatch out the function to get current experience.
-    float currentXP = -1.0;
-    auto getXPCallback =
-        RE::BSTSmartPointer<RE::BSScript::IStackCallbackFunctor>(new script_util::FloatCallbackFunctor(currentXP));
-    std::unique_ptr<RE::BSScript::IFunctionArguments> args1(RE::MakeFunctionArguments());
-    if (!papyrusVM->DispatchStaticCall("Game", "GetPlayerExperience", args1.get(), getXPCallback)) {
-        logger::error("Error in dispatch call.");
-        return;
+    // Waits on a VM callback, checking between slices that the work still belongs to the loaded game.
+    // A callback that is given up on may still be answered later, so it leaves the pool instead of being reused.
+    bool waitForCurrentCallback(CallbackPtr& pooled, const bhh_lifecycle::WorkTicket& ticket) {
+        static constexpr auto slice = std::chrono::milliseconds(50);
+        auto callback = static_cast<script_util::WaitingCallbackFunctor*>(pooled.get());
+        while (!callback->WaitForCallback(slice)) {
+            if (!ticket.IsCurrent()) {
+                logger::info("Game loading, abandoning wait on VM callback for player XP.");
+                pooled.reset();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // The player's own skill data. Only touched on the main thread, where nothing else is changing it.
+    class NativePlayerXPStore : public h2h_level::PlayerXPStore {
+    public:
+        std::optional<h2h_level::PlayerXP> Read() override {
+            auto data = skillData();
+            if (data == nullptr) {
+                return std::nullopt;
+            }
+            return h2h_level::PlayerXP{data->xp, data->levelThreshold};
+        }
+
+        bool Write(float xp) override {
+            auto data = skillData();
+            if (data == nullptr) {
+                return false;
+            }
+            data->xp = xp;
+            return true;
+        }
+
+    private:
+        static auto skillData() {
+            auto player = RE::PlayerCharacter::GetSingleton();
+            auto skills = player ? player->GetInfoRuntimeData().skills : nullptr;
+            auto data = skills != nullptr ? skills->data : nullptr;
+            if (data == nullptr) {
+                logger::error("Player skill data missing.");
+            }
+            return data;
+        }
+    };
+
+    // Game.GetPlayerExperience and SetPlayerExperience through the papyrus VM. Blocks on the VM, so only use it off the
+    // main thread, and only one at a time since the callbacks are reused between grants.
+    class VMPlayerXPStore : public h2h_level::PlayerXPStore {
+    public:
+        explicit VMPlayerXPStore(const bhh_lifecycle::WorkTicket& ticketGiven) : ticket(ticketGiven) {}
+
+        std::optional<h2h_level::PlayerXP> Read() override {
+            static const RE::BSFixedString gameClass{"Game"}, getXPFunc{"GetPlayerExperience"};
+            auto papyrusVM = RE::BSScript::Internal::VirtualMachine::GetSingleton();
+            auto getXPFunctor = acquireCallback<script_util::FloatCallbackFunctor>(getXPCallback, -1.0f);
+            RE::BSScript::FunctionArguments<void> getArgs;
+            if (!papyrusVM->DispatchStaticCall(gameClass, getXPFunc, &getArgs, getXPCallback)) {
+                logger::error("Error in dispatch call.");
+                return std::nullopt;
+            }
+            if (!waitForCurrentCallback(getXPCallback, ticket)) {
+                return std::nullopt;
+            }
+            float currentXP = getXPFunctor->GetValue();
+            if (currentXP < 0.0f) {
+                logger::error("Failed to obtain current player Level XP.");
+                return std::nullopt;
+            }
+            // Papyrus has no getter for the threshold.
+            return h2h_level::PlayerXP{currentXP, 0.0f};
+        }
+
+        bool Write(float xp) override {
+            if (!ticket.IsCurrent()) {
+                LOGTRACE("Game loading, not setting player xp.");
+                return false;
+            }
+            static const RE::BSFixedString gameClass{"Game"}, setXPFunc{"SetPlayerExperience"};
+            auto papyrusVM = RE::BSScript::Internal::VirtualMachine::GetSingleton();
+            acquireCallback<script_util::WaitingCallbackFunctor>(setXPCallback);
+            RE::BSScript::FunctionArguments<float> setArgs(std::move(xp));
+            if (!papyrusVM->DispatchStaticCall(gameClass, setXPFunc, &setArgs, setXPCallback)) {
+                logger::error("Error in dispatch call.");
+                return false;
+            }
+            return waitForCurrentCallback(setXPCallback, ticket);
+        }
+
+    private:
+        // Reused between grants, the callers' mutex keeps only one grant using them at a time.
+        static inline CallbackPtr getXPCallback, setXPCallback;
+
+        const bhh_lifecycle::WorkTicket& ticket;
+    };
+
+    // Game.SetPlayerExperience dispatched without waiting for it, for the main thread which can't block on the VM.
+    // Write only, the value to set is read from somewhere else.
+    class AsyncVMPlayerXPSetter : public h2h_level::PlayerXPStore {
+    public:
+        std::optional<h2h_level::PlayerXP> Read() override { return std::nullopt; }
+
+        bool Write(float xp) override {
+            static const RE::BSFixedString gameClass{"Game"}, setXPFunc{"SetPlayerExperience"};
+            auto papyrusVM = RE::BSScript::Internal::VirtualMachine::GetSingleton();
+            CallbackPtr noCallback;
+            RE::BSScript::FunctionArguments<float> setArgs(std::move(xp));
+            if (!papyrusVM->DispatchStaticCall(gameClass, setXPFunc, &setArgs, noCallback)) {
+                logger::error("Error in dispatch call.");
+                return false;
+            }
+            return true;
+        }
+    };
+
+    void givePlayerXPVM(float xpGained, const bhh_lifecycle::WorkTicket& ticket) {
+        static std::mutex xpFuncMutex;
+        std::lock_guard<std::mutex> guard(xpFuncMutex);
+        if (!ticket.IsCurrent()) {
+            LOGTRACE("Dropping player xp of {} from previous game session.", xpGained);
+            return;
+        }
+        LOGTRACE("Processing player level xp of {}.", xpGained);
+        VMPlayerXPStore store(ticket);
+        if (h2h_level::GrantPlayerXP(store, xpGained)) {
+            LOGTRACE("XP Gain Finished");
+        }
     }
-    // Wait for the result of the current XP. We're going to use it to then set the new XP.
-    dynamic_cast<script_util::FloatCallbackFunctor*>(getXPCallback.get())->WaitForCallback();
-    if (currentXP < 0.0) {
-        logger::error("Failed to obtain current player Level XP.");
+
+    // Player xp waiting for the main thread. The ticket stays with the worker, so its generation comes along instead.
+    struct NativeGrant {
+        float xpGained;
+        std::uint32_t generation;
+    };
+
+    void applyNativeGrant(NativeGrant& grant) {
+        if (!bhh_lifecycle::WorkTracker::GetSingleton()->IsCurrent(grant.generation)) {
+            LOGTRACE("Dropping player xp of {} from previous game session.", grant.xpGained);
+            return;
+        }
+        // Whatever the game does once experience reaches the level threshold happens inside its own setter, so the
+        // grant that fills the bar still goes through Game.SetPlayerExperience. Decided here against the value the
+        // grant is added to, so grants still waiting in this batch are counted.
+        NativePlayerXPStore native;
+        AsyncVMPlayerXPSetter levelUp;
+        h2h_level::GrantPlayerXP(native, levelUp, grant.xpGained);
     }
-    float newXP = currentXP + xpGained;
-    LOGTRACE("Player XP: {}, new XP {}", currentXP, newXP);
+}
 
-    // Create dispatch not to actually update XP
-    auto setXPCallback =
-        RE::BSTSmartPointer<RE::BSScript::IStackCallbackFunctor>(new script_util::WaitingCallbackFunctor{});
-    std::unique_ptr<RE::BSScript::IFunctionArguments> args3(RE::MakeFunctionArguments(std::move(newXP)));
-    if (!papyrusVM->DispatchStaticCall("Game", "SetPlayerExperience", args3.get(), setXPCallback)) {
-        logger::error("Error in dispatch call.");
+void h2h_level::GivePlayerXP(float xpGained, const bhh_lifecycle::WorkTicket& ticket) {
+    if (!ticket.IsCurrent()) {
+        LOGTRACE("Dropping player xp of {} from previous game session.", xpGained);
+        return;
+    }
+    if (Settings.NativePlayerXP.value == 0.0f) {
+        givePlayerXPVM(xpGained, ticket);
         return;
     }
-    dynamic_cast<script_util::WaitingCallbackFunctor*>(setXPCallback.get())->WaitForCallback();
-    LOGTRACE("XP Gain Finished");
+    static bhh_events::MainThreadTask<NativeGrant, 32> nativeTask("Player XP", applyNativeGrant);
+    if (!nativeTask.Push({xpGained, ticket.Generation()})) {
+        logger::warn("Native player xp queue full, giving {} player xp through papyrus.", xpGained);
+        givePlayerXPVM(xpGained, ticket);
+    }
 }
 
 StartingSkillManager* StartingSkillManager::GetSingleton() {
@@ -99,18 +252,29 @@ bool StartingSkillManager::RegisterForRaceMenuDone() {
         logger::error("Failed to get UI event source holder when trying to register race menu complete event.");
         return false;
     }
-    ui->AddEventSink(this);
+    if (!bhh_events::SinkRegistry::GetSingleton()->Attach("StartingSkillManager", this,
+                                                          ui->GetEventSource<RE::MenuOpenCloseEvent>(), true)) {
+        return false;
+    }
     logger::info("Skill manager ready to set skill values after racemenu close");
     return true;
 }
 
+void StartingSkillManager::ResetSession() {
+    newCharacter = false;
+}
+
 RE::BSEventNotifyControl StartingSkillManager::ProcessEvent(const RE::MenuOpenCloseEvent* event,
                                                             RE::BSTEventSource<RE::MenuOpenCloseEvent>*) {
+    bhh_events::SinkRegistry::GetSingleton()->RecordDispatch(this);
     if (event->opening || event->menuName != "RaceSex Menu") {
         return RE::BSEventNotifyControl::kContinue;
     }
+    // Only needed once per character, stop listening to every menu change.
+    bhh_events::SinkRegistry::GetSingleton()->Detach(this);
     if (glob.skillLevel->value != 0) {
         logger::info("Skill level already set, no starting skill management needed.");
+        newCharacter = false;
         return RE::BSEventNotifyControl::kStop;
     }
 
@@ -0,0 +1,49 @@
+#include "hitdedupe.hpp"
+
+using bhh_events::HitDedupe;
+
+void HitDedupe::Configure(std::chrono::milliseconds windowGiven, bool slidingGiven) {
+    window = windowGiven;
+    sliding = slidingGiven;
+    Reset();
+}
+
+bool HitDedupe::IsDuplicate(RE::FormID target, RE::FormID source, Clock::time_point now) {
+    if (window <= Clock::duration::zero() || target == 0) {
+        ++passed;
+        return false;
+    }
+    auto home = HomeSlot(target, source);
+
+    Entry* victim = nullptr;
+    for (std::size_t probe = 0; probe < maxProbe; ++probe) {
+        auto& entry = entries[(home + probe) & (slots - 1)];
+        bool live = entry.target != 0 && now - entry.windowStart < window;
+        if (live && entry.target == target && entry.source == source) {
+            if (sliding) {
+                entry.windowStart = now;
+            }
+            ++dropped;
+            return true;
+        }
+        // Empty and expired slots always started before live ones, so the oldest slot is the one to reuse.
+        if (victim == nullptr || entry.windowStart < victim->windowStart) {
+            victim = &entry;
+        }
+    }
+    *victim = Entry{target, source, now};
+    ++passed;
+    return false;
+}
+
+std::size_t HitDedupe::HomeSlot(RE::FormID target, RE::FormID source) {
+    auto hash = static_cast<std::uint32_t>(target * 2654435761u) ^ static_cast<std::uint32_t>(source * 0x85EBCA6Bu);
+    hash ^= hash >> 16;
+    return hash & (slots - 1);
+}
+
+void HitDedupe::Reset() {
+    entries.fill(Entry{});
+    passed = 0;
+    dropped = 0;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "RE/Skyrim.h"
+
+namespace bhh_events {
+    /*
+     * Collapses the extra TESHitEvents one punch raises (enchantments, perk spell effects, bash plus weapon hits)
+     * before any XP work is done for them. Hits are keyed on (target, source) and a repeat inside the window is a
+     * duplicate. In sliding mode every duplicate restarts the window, otherwise it runs from the first hit.
+     * Small open addressing table with a bounded probe; expired slots are reused in place, so nothing is allocated.
+     */
+    class HitDedupe {
+    public:
+        using Clock = std::chrono::steady_clock;
+        static constexpr std::size_t slots = 64;
+        static constexpr std::size_t maxProbe = 8;
+
+        // A window of 0 turns suppression off.
+        void Configure(std::chrono::milliseconds windowGiven, bool slidingGiven);
+        // True if this hit repeats one seen inside the window and should be dropped.
+        bool IsDuplicate(RE::FormID target, RE::FormID source, Clock::time_point now);
+        // Clears remembered hits and counters.
+        void Reset();
+        // Slot a (target, source) pair starts probing from.
+        static std::size_t HomeSlot(RE::FormID target, RE::FormID source);
+
+        // Hits that weren't duplicates. Only dedupe is counted, the hit handler may still filter these out.
+        std::uint64_t Passed() const { return passed; }
+        std::uint64_t Dropped() const { return dropped; }
+
+    private:
+        struct Entry {
+            RE::FormID target = 0;
+            RE::FormID source = 0;
+            Clock::time_point windowStart{};
+        };
+        std::array<Entry, slots> entries{};
+        Clock::duration window{};
+        bool sliding = false;
+        std::uint64_t passed = 0;
+        std::uint64_t dropped = 0;
+    };
+}
@@ -4,7 +4,9 @@
 #include "formutil.hpp"
 #include "h2hlevel.hpp"
 #include "logger.hpp"
+#include "papyrus.hpp"
 #include "scriputil.hpp"
+#include "sinkregistry.hpp"
 
 using bhh_events::HitEventHandler;
 
@@ -32,11 +34,42 @@ bool HitEventHandler::Register() {
     // Get Unarmed weapon keyword
     if (!initFormFromEditorId(handler->keyword.unarmedWeapKeywordId, handler->keyword.unarmedKeyword)) return false;
 
+    {
+        auto const& settings = h2h_level::Settings;
+        std::lock_guard<std::mutex> guard(handler->xpMutex);
+        handler->xpDecay.Configure(static_cast<std::size_t>(settings.DRCapacity.value), settings.DRHalfLife.value,
+                                   settings.DRPenaltyPerHit.value, settings.DRMinMultiplier.value);
+        handler->hits.Configure(std::chrono::milliseconds(static_cast<std::int64_t>(settings.DedupeWindowMs.value)),
+                                settings.DedupeSliding.value != 0.0f);
+        handler->ready = true;
+    }
+    // One long lived worker for all hits, started once since Register only runs on data load.
+    std::thread(&HitEventHandler::workerLoop, handler).detach();
+
     // Finally actually register listener now that we have what we need
     RE::ScriptEventSourceHolder* eventHolder = RE::ScriptEventSourceHolder::GetSingleton();
-    eventHolder->AddEventSink(handler);
-    logger::info("HitEvent event registered.");
-    return true;
+    if (eventHolder == nullptr) {
+        logger::error("Failed to get script event source holder for hit events.");
+        return false;
+    }
+    return bhh_events::SinkRegistry::GetSingleton()->Attach("HitEventHandler", handler,
+                                                            eventHolder->GetEventSource<RE::TESHitEvent>(), false);
+}
+
+void HitEventHandler::ResetSession() {
+    hits.ResetSession();
+    std::lock_guard<std::mutex> guard(xpMutex);
+    LOGTRACE("Clearing diminishing returns, {} defenders evicted last session.", xpDecay.Evictions());
+    xpDecay.Clear();
+}
+
+h2h_level::SkillState HitEventHandler::GetSkillState() const {
+    std::lock_guard<std::mutex> guard(xpMutex);
+    if (!ready) {
+        return {};
+    }
+    return h2h_level::MakeSkillState(glob.skillLevel->value, glob.skillExp->value, glob.skillRatio->value,
+                                     glob.skillShowLevelUp->value, gamesetting.xpSkillCurve->GetFloat());
 }
 
 // Checks if player is in beast form and if so are we allowed to collect XP in beast form
@@ -47,6 +80,7 @@ bool HitEventHandler::AllowedForm() const {
 
 RE::BSEventNotifyControl HitEventHandler::ProcessEvent(const RE::TESHitEvent* event,
                                                        RE::BSTEventSource<RE::TESHitEvent>*) {
+    bhh_events::SinkRegistry::GetSingleton()->RecordDispatch(this);
     if (glob.skillLevel->value >= h2h_level::Settings.SkillMaxLevel) {
         LOGTRACE("Character at max level, no more xp hit processing.");
         return RE::BSEventNotifyControl::kContinue;
@@ -72,6 +106,10 @@ RE::BSEventNotifyControl HitEventHandler::ProcessEvent(const RE::TESHitEvent* ev
         LOGTRACE("Ignoring hit from either non player source or non actor target.");
         return RE::BSEventNotifyControl::kContinue;
     }
+    if (hits.IsDuplicate(event->target->GetFormID(), event->source, std::chrono::steady_clock::now())) {
+        LOGTRACE("Dropping duplicate hit on 0x{:x} from 0x{:x}.", event->target->GetFormID(), event->source);
+        return RE::BSEventNotifyControl::kContinue;
+    }
     LOGTRACE("Player hit Event recieved: attacker {}, target {}", event->cause->GetDisplayFullName(),
              event->target->GetDisplayFullName());
 
@@ -95,18 +133,43 @@ RE::BSEventNotifyControl HitEventHandler::ProcessEvent(const RE::TESHitEvent* ev
         LOGTRACE("Defender is dead or not valid.");
         return RE::BSEventNotifyControl::kContinue;
     }
-    // We have everything we need from this hit, return now. Process the hit xp in a different thread.
-    std::thread(&HitEventHandler::ApplyHandToHandXP, this, defender, attackingWeapon).detach();
+    // We have everything we need from this hit, return now. Process the hit xp on the worker thread.
+    // Hand over a handle rather than the actor so a load can't leave the worker holding a dead pointer.
+    if (!hits.Push(defender->GetHandle(), attackingWeapon)) {
+        LOGTRACE("XP worker backed up, dropping hit.");
+    }
     return RE::BSEventNotifyControl::kContinue;
 }
 
-void HitEventHandler::ApplyHandToHandXP(RE::Actor* defender, RE::TESObjectWEAP* weapon) const {
+void HitEventHandler::workerLoop() {
+    while (true) {
+        auto job = hits.Pop();
+        auto playerLevelXP = ApplyHandToHandXP(job.defender, job.weapon, job.ticket);
+        // Outside the xp lock, this can wait on the papyrus VM.
+        if (playerLevelXP > 0.0f) {
+            LOGTRACE("Dispatching player xp func");
+            h2h_level::GivePlayerXP(playerLevelXP, job.ticket);
+        }
+    }
+}
+
+float HitEventHandler::ApplyHandToHandXP(RE::ActorHandle defenderHandle, RE::TESObjectWEAP* weapon,
+                                         const bhh_lifecycle::WorkTicket& ticket) {
     static auto player = RE::PlayerCharacter::GetSingleton();
-    static std::mutex xpFuncMutex;
-    std::lock_guard<std::mutex> guard(xpFuncMutex);
+    std::lock_guard<std::mutex> guard(xpMutex);
+    if (!ticket.IsCurrent()) {
+        LOGTRACE("Dropping hit xp from previous game session.");
+        return 0.0f;
+    }
     if (glob.skillLevel->value >= h2h_level::Settings.SkillMaxLevel) {
-        return;
+        return 0.0f;
+    }
+    auto defenderPtr = defenderHandle.get();
+    if (!defenderPtr) {
+        LOGTRACE("Defender no longer loaded, ignoring hit.");
+        return 0.0f;
     }
+    auto defender = defenderPtr.get();
     LOGTRACE("Processing hand to hand xp from hit.");
     // Calculate assumed base damage of a current unarmed hit.
     auto damage = player->CalcUnarmedDamage();
@@ -127,41 +190,32 @@ void HitEventHandler::ApplyHandToHandXP(RE::Actor* defender, RE::TESObjectWEAP*
     LOGTRACE("Skill improve mult: {}", skillImprove);
     LOGTRACE("Calculating skill xp with skillimprove = {}, skillMod = {}", skillImprove, glob.skillXPMod->value);
     float xpGain = skillImprove * h2h_level::calcSkillXpGain(damage) * glob.skillXPMod->value;
+    auto decayMult = xpDecay.RecordHit(defender->GetFormID(), std::chrono::steady_clock::now());
+    LOGTRACE("Diminishing returns mult on 0x{:x}: {}", defender->GetFormID(), decayMult);
+    xpGain *= decayMult;
     if (xpGain <= 0) {
         logger::info("XP gain was less than or equal to 0. No H2H exp added.");
-        return;
-    }
-    float xpNeeded = h2h_level::nextSkillLevelXP(glob.skillLevel->value, gamesetting.xpSkillCurve->GetFloat());
-    LOGTRACE("XP for next level at {}, with skill curve {}, is {}", glob.skillLevel->value,
-             gamesetting.xpSkillCurve->GetFloat(), xpNeeded);
-    logger::info("XP Gain is {}", xpGain);
-
-    auto newExp = glob.skillExp->value + xpGain;
-    float playerLevelXP = 0.0f;
-    while (newExp >= xpNeeded && glob.skillLevel->value < h2h_level::Settings.SkillMaxLevel) {
-        // Temp set this to one to show that it's been filled.
-        glob.skillRatio->value = 1.0;
-        // Skill Level Up
-        float newLevel = glob.skillLevel->value + 1.0f;
-        LOGTRACE("New Skill level {}", newLevel);
-        glob.skillShowLevelUp->value = newLevel;
-        glob.skillLevel->value = newLevel;
-        newExp -= xpNeeded;
-        xpNeeded = h2h_level::nextSkillLevelXP(newLevel, gamesetting.xpSkillCurve->GetFloat());
-        LOGTRACE("New XP need for next level {}", xpNeeded);
-        if (glob.enablePlayerXP->value != 0) {
-            playerLevelXP += newLevel * gamesetting.xpPerSkillRank->GetFloat();
-        }
+        return 0.0f;
     }
-    if (playerLevelXP > 0.0) {
-        LOGTRACE("Dispatching player xp func");
-        std::thread(h2h_level::GivePlayerXP, playerLevelXP).detach();
+    if (!ticket.IsCurrent()) {
+        LOGTRACE("Game loading, dropping hit xp result.");
+        return 0.0f;
     }
-    if (glob.skillLevel->value >= h2h_level::Settings.SkillMaxLevel) {
-        glob.skillExp->value = 0.0f;
-        glob.skillRatio->value = 0.0f;
-        return;
+    LOGTRACE("XP Gain is {}", xpGain);
+    auto oldLevel = glob.skillLevel->value;
+    auto gain = h2h_level::addSkillXP(oldLevel, glob.skillExp->value, xpGain, gamesetting.xpSkillCurve->GetFloat());
+    for (int level = 1; level <= gain.levelsGained; ++level) {
+        LOGTRACE("New Skill level {}", oldLevel + level);
+        bhh_papyrus::SendLevelUpEvent(oldLevel + static_cast<float>(level));
+    }
+    if (gain.levelsGained > 0) {
+        glob.skillShowLevelUp->value = gain.level;
     }
-    glob.skillExp->value = newExp;
-    glob.skillRatio->value = newExp / xpNeeded;
-}
\ No newline at end of file
+    glob.skillLevel->value = gain.level;
+    glob.skillExp->value = gain.exp;
+    glob.skillRatio->value = gain.ratio;
+    if (glob.enablePlayerXP->value == 0) {
+        return 0.0f;
+    }
+    return gain.levelSum * gamesetting.xpPerSkillRank->GetFloat();
+}
@@ -1,5 +1,9 @@
 #pragma once
 #include "RE/Skyrim.h"
+#include "h2hlevel.hpp"
+#include "hitqueue.hpp"
+#include "lifecycle.hpp"
+#include "xpdecay.hpp"
 
 namespace bhh_events {
     class HitEventHandler : public RE::BSTEventSink<RE::TESHitEvent> {
@@ -10,6 +14,12 @@ namespace bhh_events {
         RE::BSEventNotifyControl ProcessEvent(const RE::TESHitEvent* a_event,
                                               RE::BSTEventSource<RE::TESHitEvent>* a_eventSource) override;
 
+        // Forget per save state before another save is loaded or a new game starts.
+        void ResetSession();
+
+        // Current skill values read under the same lock the XP processing uses. Zeroed if not registered yet.
+        h2h_level::SkillState GetSkillState() const;
+
     private:
         // Game settings
         struct {
@@ -36,9 +46,18 @@ namespace bhh_events {
             RE::BGSKeyword* unarmedKeyword;
         } keyword;
 
+        // Guards the skill globals while XP is being applied.
+        mutable std::mutex xpMutex;
+        bool ready = false;
+        h2h_level::DiminishingReturns xpDecay;
+        HitQueue hits;
+
         HitEventHandler() = default;
         ~HitEventHandler() = default;
-        void ApplyHandToHandXP(RE::Actor* defender, RE::TESObjectWEAP* weapon) const;
+        void workerLoop();
+        // Returns the player level XP earned by any skill level ups from this hit.
+        float ApplyHandToHandXP(RE::ActorHandle defenderHandle, RE::TESObjectWEAP* weapon,
+                                const bhh_lifecycle::WorkTicket& ticket);
         bool AllowedForm() const;
     };
 }
@@ -0,0 +1,43 @@
+#include "hitqueue.hpp"
+
+#include "logger.hpp"
+
+using bhh_events::HitQueue;
+
+void HitQueue::Configure(std::chrono::milliseconds dedupeWindow, bool dedupeSliding) {
+    dedupe.Configure(dedupeWindow, dedupeSliding);
+}
+
+bool HitQueue::IsDuplicate(RE::FormID target, RE::FormID source, Clock::time_point now) {
+    return dedupe.IsDuplicate(target, source, now);
+}
+
+bool HitQueue::Push(RE::ActorHandle defender, RE::TESObjectWEAP* weapon) {
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        if (!jobs.TryPush({defender, weapon, bhh_lifecycle::WorkTracker::GetSingleton()->Begin()})) {
+            ++drops;
+            return false;
+        }
+    }
+    cv.notify_one();
+    return true;
+}
+
+HitQueue::Job HitQueue::Pop() {
+    std::unique_lock<std::mutex> lck(mtx);
+    cv.wait(lck, [this]() { return !jobs.Empty(); });
+    // Moved out rather than assigned, the ticket inside can't be move assigned.
+    return std::move(*jobs.TryPop());
+}
+
+void HitQueue::ResetSession() {
+    logger::info("Hit dedupe last session: {} hits passed, {} duplicates dropped.", dedupe.Passed(),
+                 dedupe.Dropped());
+    dedupe.Reset();
+    std::lock_guard<std::mutex> guard(mtx);
+    if (drops > 0) {
+        logger::warn("XP worker queue was full for {} hits last session.", drops);
+    }
+    drops = 0;
+}
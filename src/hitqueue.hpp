@@ -0,0 +1,42 @@
+#pragma once
+#include "RE/Skyrim.h"
+#include "hitdedupe.hpp"
+#include "lifecycle.hpp"
+#include "ringqueue.hpp"
+
+namespace bhh_events {
+    /*
+     * The game independent half of hit intake: dropping duplicate hits, then handing survivors to the XP worker with a
+     * work ticket. HitEventHandler does the game lookups and filters around it. Preallocated, nothing here allocates.
+     */
+    class HitQueue {
+    public:
+        using Clock = HitDedupe::Clock;
+        static constexpr std::size_t size = 64;
+
+        // Hits waiting for the XP worker thread.
+        struct Job {
+            RE::ActorHandle defender;
+            RE::TESObjectWEAP* weapon;
+            bhh_lifecycle::WorkTicket ticket;
+        };
+
+        void Configure(std::chrono::milliseconds dedupeWindow, bool dedupeSliding);
+        // Main thread, before the more expensive filters. True if the hit repeats a recent one and should be dropped.
+        bool IsDuplicate(RE::FormID target, RE::FormID source, Clock::time_point now);
+        // Main thread. Queues the hit for the worker, false if the worker is backed up and the hit was dropped.
+        bool Push(RE::ActorHandle defender, RE::TESObjectWEAP* weapon);
+        // Worker thread. Blocks until a hit is queued.
+        Job Pop();
+        // Logs last session's counts and clears them along with the remembered hits.
+        void ResetSession();
+
+    private:
+        // Only touched from the main thread.
+        HitDedupe dedupe;
+        std::mutex mtx;
+        std::condition_variable cv;
+        RingQueue<Job, size> jobs;
+        std::uint64_t drops = 0;
+    };
+}
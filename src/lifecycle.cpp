@@ -0,0 +1,56 @@
+#include "lifecycle.hpp"
+
+#include "logger.hpp"
+
+using bhh_lifecycle::WorkTicket;
+using bhh_lifecycle::WorkTracker;
+
+WorkTicket::WorkTicket(WorkTicket&& other) noexcept
+    : tracker(std::exchange(other.tracker, nullptr)), generation(other.generation) {}
+
+WorkTicket::~WorkTicket() {
+    if (tracker != nullptr) {
+        tracker->end();
+    }
+}
+
+bool WorkTicket::IsCurrent() const {
+    return tracker != nullptr && tracker->generation.load() == generation;
+}
+
+WorkTracker* WorkTracker::GetSingleton() {
+    static WorkTracker singleton{};
+    return std::addressof(singleton);
+}
+
+WorkTicket WorkTracker::Begin() {
+    std::lock_guard<std::mutex> guard(mtx);
+    ++inFlight;
+    return WorkTicket(this, generation.load());
+}
+
+void WorkTracker::end() {
+    std::lock_guard<std::mutex> guard(mtx);
+    if (--inFlight == 0) {
+        cv.notify_all();
+    }
+}
+
+std::size_t WorkTracker::InFlight() const {
+    std::lock_guard<std::mutex> guard(mtx);
+    return inFlight;
+}
+
+std::chrono::milliseconds WorkTracker::Drain(std::chrono::milliseconds deadline) {
+    auto start = std::chrono::steady_clock::now();
+    auto newGeneration = generation.fetch_add(1) + 1;
+    std::unique_lock<std::mutex> lck(mtx);
+    bool drained = cv.wait_for(lck, deadline, [this]() { return inFlight == 0; });
+    auto took = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    if (drained) {
+        logger::info("XP work drained in {} ms, starting generation {}.", took.count(), newGeneration);
+    } else {
+        logger::warn("{} XP jobs still running after {} ms. Their results will be dropped.", inFlight, took.count());
+    }
+    return took;
+}
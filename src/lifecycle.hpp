@@ -0,0 +1,59 @@
+#pragma once
+
+namespace bhh_lifecycle {
+    class WorkTracker;
+
+    /*
+     * Held by a piece of XP work for as long as it runs. Remembers the session generation the work started in so it
+     * can tell whether its results still belong to the loaded game. Releases its in flight slot when destroyed.
+     */
+    class WorkTicket {
+    public:
+        WorkTicket(WorkTicket&& other) noexcept;
+        WorkTicket(const WorkTicket&) = delete;
+        WorkTicket& operator=(const WorkTicket&) = delete;
+        WorkTicket& operator=(WorkTicket&&) = delete;
+        ~WorkTicket();
+
+        // False once a load or new game has started since this work began.
+        bool IsCurrent() const;
+        // For work handed off somewhere a ticket can't follow, check it later with WorkTracker::IsCurrent.
+        std::uint32_t Generation() const { return generation; }
+
+    private:
+        friend class WorkTracker;
+        WorkTicket(WorkTracker* trackerGiven, std::uint32_t generationGiven)
+            : tracker(trackerGiven), generation(generationGiven) {}
+
+        WorkTracker* tracker;
+        std::uint32_t generation;
+    };
+
+    /*
+     * Tracks XP work running off the main thread so game loads don't race it.
+     * Drain starts a new generation, which makes all outstanding tickets stale so they drop their results, then waits
+     * up to a deadline for the work to finish.
+     */
+    class WorkTracker {
+    public:
+        static constexpr auto defaultDrainDeadline = std::chrono::milliseconds(250);
+
+        static WorkTracker* GetSingleton();
+
+        WorkTicket Begin();
+        bool IsCurrent(std::uint32_t gen) const { return generation.load() == gen; }
+        // Invalidates outstanding work and waits for it up to the deadline. Returns how long the wait took.
+        std::chrono::milliseconds Drain(std::chrono::milliseconds deadline = defaultDrainDeadline);
+        std::size_t InFlight() const;
+
+    private:
+        friend class WorkTicket;
+        WorkTracker() = default;
+        void end();
+
+        std::atomic<std::uint32_t> generation{0};
+        mutable std::mutex mtx;
+        std::condition_variable cv;
+        std::size_t inFlight = 0;
+    };
+}
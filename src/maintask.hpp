@@ -0,0 +1,48 @@
+#pragma once
+#include "logger.hpp"
+#include "taskbatch.hpp"
+
+namespace bhh_events {
+    /*
+     * Runs apply on the main thread for each pushed item. The task object is reused for every batch instead of SKSE
+     * wrapping a new std::function per item, so queueing work from event sinks and workers doesn't allocate.
+     * Give it static storage, SKSE keeps a pointer to it until the batch runs.
+     */
+    template <class T, std::size_t N>
+    class MainThreadTask : public SKSE::detail::TaskDelegate {
+    public:
+        using Apply = void (*)(T&);
+
+        MainThreadTask(const char* nameGiven, Apply applyGiven) : name(nameGiven), apply(applyGiven) {}
+
+        // False if the item was dropped.
+        bool Push(T item) {
+            switch (batch.Push(std::move(item))) {
+            case TaskBatch<T, N>::PushResult::kFull:
+                LOGTRACE("{} batch full, dropping item.", name);
+                return false;
+            case TaskBatch<T, N>::PushResult::kScheduleDrain:
+                if (auto tasks = SKSE::GetTaskInterface()) {
+                    tasks->AddTask(this);
+                } else {
+                    logger::error("Task interface missing, dropping {} batch.", name);
+                    batch.Drain([](T&) {});
+                    return false;
+                }
+                break;
+            case TaskBatch<T, N>::PushResult::kQueued:
+                break;
+            }
+            return true;
+        }
+
+        void Run() override { batch.Drain(apply); }
+        // Reused for the next batch, never freed by SKSE.
+        void Dispose() override {}
+
+    private:
+        const char* name;
+        Apply apply;
+        TaskBatch<T, N> batch;
+    };
+}
@@ -0,0 +1,41 @@
+#include "papyrus.hpp"
+
+#include "hithandler.hpp"
+#include "logger.hpp"
+#include "maintask.hpp"
+
+namespace {
+    // float[] BHH_Native.GetSkillState() global native
+    std::vector<float> GetSkillState(RE::StaticFunctionTag*) {
+        return h2h_level::SkillStateToArray(bhh_events::HitEventHandler::GetSingleton()->GetSkillState());
+    }
+
+    // Main thread side of SendLevelUpEvent.
+    void sendLevelUpEvent(float& newLevel) {
+        static const RE::BSFixedString eventName{bhh_papyrus::levelUpEventName};
+        auto modEvents = SKSE::GetModCallbackEventSource();
+        if (modEvents == nullptr) {
+            logger::error("Mod callback event source missing, dropping level up event.");
+            return;
+        }
+        SKSE::ModCallbackEvent modEvent{eventName, RE::BSFixedString(), newLevel, nullptr};
+        modEvents->SendEvent(&modEvent);
+    }
+}
+
+bool bhh_papyrus::RegisterFunctions(RE::BSScript::IVirtualMachine* vm) {
+    if (vm == nullptr) {
+        logger::error("Papyrus VM not provided, native functions not registered.");
+        return false;
+    }
+    vm->RegisterFunction("GetSkillState", scriptName, GetSkillState);
+    logger::info("Registered native papyrus functions for {}.", scriptName);
+    return true;
+}
+
+void bhh_papyrus::SendLevelUpEvent(float newLevel) {
+    static bhh_events::MainThreadTask<float, 16> levelUpTask("Level up event", sendLevelUpEvent);
+    if (!levelUpTask.Push(newLevel)) {
+        logger::error("Dropping level up event for level {}.", newLevel);
+    }
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include "RE/Skyrim.h"
+
+/*
+ * Native papyrus functions so the MCM and level up scripts don't have to poll the skill globals.
+ * Declare these in the BHH_Native script as global native functions.
+ */
+namespace bhh_papyrus {
+    static constexpr auto scriptName = "BHH_Native";
+    // Mod event sent each time the hand to hand skill levels up. numArg holds the new level.
+    static constexpr auto levelUpEventName = "BHH_HandToHandLevelUp";
+
+    bool RegisterFunctions(RE::BSScript::IVirtualMachine* vm);
+
+    // Queues the level up mod event onto the main thread.
+    void SendLevelUpEvent(float newLevel);
+}
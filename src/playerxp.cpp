@@ -0,0 +1,28 @@
+#include "playerxp.hpp"
+
+#include "logger.hpp"
+
+h2h_level::PlayerXP h2h_level::addPlayerXP(PlayerXP current, float xpGained) {
+    current.xp = std::max(0.0f, current.xp + xpGained);
+    return current;
+}
+
+bool h2h_level::GrantPlayerXP(PlayerXPStore& store, float xpGained) { return GrantPlayerXP(store, store, xpGained); }
+
+bool h2h_level::GrantPlayerXP(PlayerXPStore& store, PlayerXPStore& levelUpStore, float xpGained) {
+    auto current = store.Read();
+    if (!current) {
+        LOGTRACE("No current player xp, {} player xp not given.", xpGained);
+        return false;
+    }
+    auto updated = addPlayerXP(*current, xpGained);
+    LOGTRACE("Player XP: {}, new XP {}, level threshold {}", current->xp, updated.xp, updated.levelThreshold);
+    auto const crosses = crossesLevelThreshold(*current, xpGained);
+    if (!(crosses ? levelUpStore : store).Write(updated.xp)) {
+        return false;
+    }
+    if (crosses) {
+        logger::info("Hand to hand xp filled player level experience, level up ready.");
+    }
+    return true;
+}
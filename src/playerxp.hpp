@@ -0,0 +1,41 @@
+#pragma once
+
+/*
+ * Player level experience bookkeeping, kept apart from where the values live so the native and papyrus routes share
+ * it.
+ */
+namespace h2h_level {
+    // Player level experience and the amount needed for the next character level.
+    struct PlayerXP {
+        float xp = 0.0f;
+        float levelThreshold = 0.0f;
+    };
+    // Same bookkeeping the game does for skill increases. Experience keeps piling up past the threshold, the level
+    // up itself waits for the player in the stats menu.
+    PlayerXP addPlayerXP(PlayerXP current, float xpGained);
+    inline bool canLevelUp(const PlayerXP& current) {
+        return current.levelThreshold > 0.0f && current.xp >= current.levelThreshold;
+    }
+    // True if this gain is the one that fills the bar and makes a level up available.
+    inline bool crossesLevelThreshold(const PlayerXP& current, float xpGained) {
+        return !canLevelUp(current) && canLevelUp(addPlayerXP(current, xpGained));
+    }
+
+    /*
+     * Somewhere the player's level experience can be read and written, either the player's skill data or the papyrus
+     * Game functions.
+     */
+    class PlayerXPStore {
+    public:
+        virtual ~PlayerXPStore() = default;
+        // Empty if the current value couldn't be read. A threshold of 0 means it isn't known.
+        virtual std::optional<PlayerXP> Read() = 0;
+        virtual bool Write(float xp) = 0;
+    };
+
+    // Reads, adds and writes back. Nothing is written if the read fails.
+    bool GrantPlayerXP(PlayerXPStore& store, float xpGained);
+    // Same, except the grant that fills the bar is written to levelUpStore instead, for when whatever should happen
+    // at the threshold only happens through that route.
+    bool GrantPlayerXP(PlayerXPStore& store, PlayerXPStore& levelUpStore, float xpGained);
+}
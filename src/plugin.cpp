@@ -1,23 +1,81 @@
 #include "animhandler.hpp"
 #include "h2hlevel.hpp"
 #include "hithandler.hpp"
+#include "lifecycle.hpp"
 #include "logger.hpp"
+#include "papyrus.hpp"
+#include "sinkregistry.hpp"
 
 namespace {
+    // Set while a save is loaded or a new game is running.
+    std::atomic<bool> sessionActive = false;
+
+    // Game state is about to change. Drop anything tied to the previous session.
+    void endSession() {
+        sessionActive = false;
+        bhh_lifecycle::WorkTracker::GetSingleton()->Drain();
+        bhh_events::HitEventHandler::GetSingleton()->ResetSession();
+        auto sinks = bhh_events::SinkRegistry::GetSingleton();
+        sinks->LogStats();
+        sinks->DetachSession();
+        bhh_events::AnimHandler::GetSingleton()->ResetSession();
+        h2h_level::StartingSkillManager::GetSingleton()->ResetSession();
+    }
+
+    // Quitting to the main menu sends no SKSE message, so end the session when the main menu opens during one.
+    class MainMenuWatcher : public RE::BSTEventSink<RE::MenuOpenCloseEvent> {
+    public:
+        static MainMenuWatcher* GetSingleton() {
+            static MainMenuWatcher singleton{};
+            return std::addressof(singleton);
+        }
+
+        static bool Register() {
+            auto ui = RE::UI::GetSingleton();
+            if (ui == nullptr) {
+                logger::error("Failed to get UI event source holder when trying to watch for the main menu.");
+                return false;
+            }
+            return bhh_events::SinkRegistry::GetSingleton()->Attach(
+                "MainMenuWatcher", GetSingleton(), ui->GetEventSource<RE::MenuOpenCloseEvent>(), false);
+        }
+
+        RE::BSEventNotifyControl ProcessEvent(const RE::MenuOpenCloseEvent* event,
+                                              RE::BSTEventSource<RE::MenuOpenCloseEvent>*) override {
+            bhh_events::SinkRegistry::GetSingleton()->RecordDispatch(this);
+            if (event != nullptr && event->opening && event->menuName == RE::MainMenu::MENU_NAME && sessionActive) {
+                logger::info("Returned to the main menu, ending the game session.");
+                endSession();
+            }
+            return RE::BSEventNotifyControl::kContinue;
+        }
+
+    private:
+        MainMenuWatcher() = default;
+    };
+
     static void SKSEMessageHandler(SKSE::MessagingInterface::Message* message) {
         static bool ssmOk = false;
         switch (message->type) {
         case SKSE::MessagingInterface::kDataLoaded:
             bhh_events::HitEventHandler::Register();
+            MainMenuWatcher::Register();
             ssmOk = h2h_level::StartingSkillManager::GetSingleton()->LoadForms();
             break;
+        case SKSE::MessagingInterface::kPreLoadGame:
+            endSession();
+            break;
         case SKSE::MessagingInterface::kPostLoadGame:
+            sessionActive = true;
             bhh_events::AnimHandler::Register();
             if (ssmOk) {
                 h2h_level::StartingSkillManager::GetSingleton()->HandleExistingCharacter();
             }
             break;
         case SKSE::MessagingInterface::kNewGame:
+            // Normally already ended when the main menu opened, this catches anything started since.
+            endSession();
+            sessionActive = true;
             if (ssmOk) {
                 h2h_level::StartingSkillManager::GetSingleton()->RegisterForRaceMenuDone();
             }
@@ -32,5 +90,8 @@ SKSEPluginLoad(const SKSE::LoadInterface* skse) {
     h2h_level::LoadSettingsINI();
     logger::info("Registering {}, Version {}, for load.", plugin->GetName(), plugin->GetVersion());
     SKSE::GetMessagingInterface()->RegisterListener("SKSE", SKSEMessageHandler);
+    if (!SKSE::GetPapyrusInterface()->Register(bhh_papyrus::RegisterFunctions)) {
+        logger::error("Failed to register native papyrus functions.");
+    }
     return true;
 }
@@ -0,0 +1,41 @@
+#pragma once
+
+namespace bhh_events {
+    /*
+     * Fixed capacity FIFO over preallocated slots, pushing and popping never allocate.
+     * Not thread safe on its own, guard it with the owner's mutex.
+     */
+    template <class T, std::size_t N>
+    class RingQueue {
+    public:
+        // False if full, the item is left untouched.
+        bool TryPush(T&& item) {
+            if (count == N) {
+                return false;
+            }
+            slots[(head + count) % N].emplace(std::move(item));
+            ++count;
+            return true;
+        }
+
+        std::optional<T> TryPop() {
+            if (count == 0) {
+                return std::nullopt;
+            }
+            auto& slot = slots[head];
+            std::optional<T> item{std::move(*slot)};
+            slot.reset();
+            head = (head + 1) % N;
+            --count;
+            return item;
+        }
+
+        bool Empty() const { return count == 0; }
+        std::size_t Size() const { return count; }
+
+    private:
+        std::array<std::optional<T>, N> slots{};
+        std::size_t head = 0;
+        std::size_t count = 0;
+    };
+}
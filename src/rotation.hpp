@@ -0,0 +1,66 @@
+#pragma once
+
+/*
+ * Which animation events toggle hand to hand attack rotation and which way they turn it.
+ * String views only, this runs for every animation event so nothing is copied.
+ */
+namespace bhh_events {
+    struct AnimTags {
+        // This appears to be the animation tag used by all attack start animations.
+        // Does not play on repeated attack strings
+        static constexpr auto attackStart = "PowerAttack_Start_end";
+
+        // This appears to only occur once! even in combo attacks.
+        // This is a suitable since its seems like the best event to catch exactly one attack input.
+        static constexpr auto preHitFrame = "preHitFrame";
+
+        // These one show up when a player spams a light attack
+        static constexpr auto attackFollow = "AttackWinStart";
+        static constexpr auto attackFollowLeft = "AttackWinStartLeft";
+
+        // This sems to be the only power attack unique anim tag
+        static constexpr auto powerAttackEnd = "PowerAttackStop";
+
+        // Happens at end of all attacks
+        static constexpr auto attackStop = "attackStop";
+    };
+    inline constexpr AnimTags animTags{};
+
+    struct AttackEvents {
+        // These appear to the the Attack Event data associated with the different possible hand to hand attacks
+        static constexpr auto rightAttack = "AttackStartH2HRight";
+        static constexpr auto rightPowerAttack = "attackPowerStartForwardH2HRightHand";
+        static constexpr auto leftAttack = "AttackStartH2HLeft";
+        static constexpr auto leftPowerAttack = "attackPowerStartForwardH2HLeftHand";
+        static constexpr auto comboPowerAttack = "attackPowerStartH2HCombo";
+    };
+    inline constexpr AttackEvents attackEvents{};
+
+    // Whether this animation tag during this attack should toggle the rotation.
+    inline bool isRotationTag(std::string_view tag, std::string_view attackEvent) {
+        return attackEvent != attackEvents.comboPowerAttack &&  // Dont toggle on power combo
+               (tag.starts_with(animTags.attackFollow) ||       // Toggle on combo hits or...
+                tag.starts_with(animTags.attackStop));          // toggle on attack stoping all together
+    }
+
+    // Rotation the attack leaves behind, -1 after a right hand attack and 1 after a left. 0 if it isn't a hand to
+    // hand attack.
+    inline float attackRotation(std::string_view attackEvent, bool isPower) {
+        if (isPower) {
+            if (attackEvent == attackEvents.rightPowerAttack) {
+                return -1.0f;
+            }
+            if (attackEvent == attackEvents.leftPowerAttack) {
+                return 1.0f;
+            }
+            return 0.0f;
+        }
+        if (attackEvent == attackEvents.rightAttack) {
+            return -1.0f;
+        }
+        if (attackEvent == attackEvents.leftAttack) {
+            return 1.0f;
+        }
+        return 0.0f;
+    }
+}
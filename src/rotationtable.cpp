@@ -0,0 +1,73 @@
+#include "rotationtable.hpp"
+
+#include "logger.hpp"
+#include "rotation.hpp"
+
+using bhh_events::RotationTable;
+
+bool RotationTable::Track(RE::FormID formId, RE::ActorHandle handle, const RE::Actor* graphSource, float rotation) {
+    std::unique_lock<std::shared_mutex> lck(mtx);
+    auto entry = actors.Insert(formId);
+    if (entry == nullptr) {
+        return false;
+    }
+    entry->rotation = rotation;
+    entry->handle = handle;
+    entry->graphSource = graphSource;
+    return true;
+}
+
+std::optional<RotationTable::Entry> RotationTable::Untrack(RE::FormID formId) {
+    std::unique_lock<std::shared_mutex> lck(mtx);
+    auto entry = actors.Find(formId);
+    if (entry == nullptr) {
+        return std::nullopt;
+    }
+    auto dropped = *entry;
+    actors.Erase(formId);
+    return dropped;
+}
+
+bool RotationTable::IsTracked(RE::FormID formId) {
+    std::shared_lock<std::shared_mutex> lck(mtx);
+    return actors.Find(formId) != nullptr;
+}
+
+bool RotationTable::WantsEvent(RE::FormID formId, Clock::time_point now) {
+    std::shared_lock<std::shared_mutex> lck(mtx);
+    auto entry = actors.Find(formId);
+    return entry != nullptr && now - entry->lastToggleTime >= minWait;
+}
+
+float RotationTable::Toggle(RE::FormID formId, std::string_view tag, std::string_view attackEvent, bool isPower,
+                            Clock::time_point now) {
+    if (!isRotationTag(tag, attackEvent)) {
+        return 0.0f;
+    }
+    auto rotation = attackRotation(attackEvent, isPower);
+    // Once per attack, so taking it exclusively is cheap.
+    std::unique_lock<std::shared_mutex> lck(mtx);
+    auto entry = actors.Find(formId);
+    if (entry == nullptr || now - entry->lastToggleTime < minWait) {
+        return 0.0f;
+    }
+    entry->lastToggleTime = now;
+    if (rotation == 0.0f) {
+        LOGTRACE("No case reached?");
+        LOGTRACE("Event {}, Atatck Toggle: {}", attackEvent, entry->rotation);
+        return 0.0f;
+    }
+    entry->rotation = rotation;
+    entry->toggled = true;
+    return rotation;
+}
+
+void RotationTable::Clear() {
+    std::unique_lock<std::shared_mutex> lck(mtx);
+    actors.Clear();
+}
+
+std::size_t RotationTable::Size() {
+    std::shared_lock<std::shared_mutex> lck(mtx);
+    return actors.Size();
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "RE/Skyrim.h"
+#include "formidtable.hpp"
+
+namespace bhh_events {
+    /*
+     * The game independent half of attack rotation: which actors are tracked, their current rotation and the toggle
+     * debounce. AnimHandler does the game lookups and applies what Toggle returns. Thread safe, animation events come
+     * in from several threads at once. Preallocated, nothing here allocates.
+     */
+    class RotationTable {
+    public:
+        using Clock = std::chrono::steady_clock;
+        static constexpr std::size_t size = 1024;
+        // Shortest time between two toggles for one actor.
+        static constexpr auto minWait = std::chrono::milliseconds(400);
+
+        // Rotation and debounce state for one tracked actor.
+        struct Entry {
+            float rotation = 1.0f;
+            Clock::time_point lastToggleTime{};
+            RE::ActorHandle handle;
+            // What the graph sink was attached under in the sink registry. Only compared, never dereferenced.
+            const RE::Actor* graphSource = nullptr;
+            // Set once Toggle returned a rotation, so there is applied state to undo when the actor leaves.
+            bool toggled = false;
+        };
+
+        // Starts tracking or refreshes an existing entry. False if the table is full.
+        bool Track(RE::FormID formId, RE::ActorHandle handle, const RE::Actor* graphSource, float rotation = 1.0f);
+        // The entry that was dropped, empty if the actor wasn't tracked.
+        std::optional<Entry> Untrack(RE::FormID formId);
+        bool IsTracked(RE::FormID formId);
+        // Cheap first check for every animation event, under the shared lock. False if the actor isn't tracked or
+        // toggled too recently, and the event can be ignored.
+        bool WantsEvent(RE::FormID formId, Clock::time_point now);
+        // Called once an event passed WantsEvent and the attack data is known. Returns the rotation to apply, 0 if
+        // there is nothing to change. Each of an actor's graphs can get here at once, only the first one inside the
+        // debounce window toggles.
+        float Toggle(RE::FormID formId, std::string_view tag, std::string_view attackEvent, bool isPower,
+                     Clock::time_point now);
+
+        // Erases every entry pred(formId, entry) returns true for, under the exclusive lock. Returns how many went.
+        template <class Pred>
+        std::size_t EraseIf(Pred&& pred) {
+            std::unique_lock<std::shared_mutex> lck(mtx);
+            return actors.EraseIf(std::forward<Pred>(pred));
+        }
+
+        void Clear();
+        std::size_t Size();
+
+    private:
+        // Shared for event lookups, exclusive for tracking changes and toggles.
+        std::shared_mutex mtx;
+        FormIDTable<Entry, size> actors;
+    };
+}
@@ -5,7 +5,10 @@ using script_util::FloatCallbackFunctor;
 using script_util::WaitingCallbackFunctor;
 
 void WaitingCallbackFunctor::operator()(RE::BSScript::Variable) {
-    ready = true;
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        ready = true;
+    }
     cv.notify_all();
 }
 
@@ -16,6 +19,21 @@ void WaitingCallbackFunctor::WaitForCallback() {
     LOGTRACE("Done callback wait");
 }
 
+bool WaitingCallbackFunctor::WaitForCallback(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lck(mtx);
+    return cv.wait_for(lck, timeout, [this]() { return ready; });
+}
+
+void WaitingCallbackFunctor::Reset() {
+    std::lock_guard<std::mutex> guard(mtx);
+    ready = false;
+}
+
+void FloatCallbackFunctor::Reset() {
+    callbackVal = defaultVal;
+    WaitingCallbackFunctor::Reset();
+}
+
 void FloatCallbackFunctor::operator()(RE::BSScript::Variable result) {
     if (result.IsFloat()) {
         LOGTRACE("Return float is {}", result.GetFloat());
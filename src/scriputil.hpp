@@ -17,6 +17,10 @@ namespace script_util {
         void SetObject(const RE::BSTSmartPointer<RE::BSScript::Object>&) override{};
 
         virtual void WaitForCallback();
+        // Waits at most timeout for the callback. Returns false if it hasn't come yet.
+        bool WaitForCallback(std::chrono::milliseconds timeout);
+        // Readies an answered functor for another dispatch. Never call while a dispatch is still waiting.
+        virtual void Reset();
 
     protected:
         std::mutex mtx;
@@ -24,15 +28,19 @@ namespace script_util {
         bool ready = false;
     };
 
-    // FloatCallbackFunctor and fills it with the result of callback
+    // FloatCallbackFunctor stores the float result of the callback. Value is only valid after the wait succeeds.
+    // Keeps its own copy so a waiter that gives up doesn't leave the VM writing into a dead stack frame.
     class FloatCallbackFunctor : public WaitingCallbackFunctor {
     public:
-        explicit FloatCallbackFunctor(float& floatStore) : callbackVal(floatStore) {}
+        explicit FloatCallbackFunctor(float defaultGiven) : defaultVal(defaultGiven), callbackVal(defaultGiven) {}
         virtual ~FloatCallbackFunctor() = default;
 
         void operator()(RE::BSScript::Variable result) override;
+        void Reset() override;
+        float GetValue() const { return callbackVal; }
 
     private:
-        float& callbackVal;
+        const float defaultVal;
+        float callbackVal;
     };
 }
\ No newline at end of file
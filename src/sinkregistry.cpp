@@ -0,0 +1,123 @@
+#include "sinkregistry.hpp"
+
+#include "logger.hpp"
+
+using bhh_events::SinkRegistry;
+
+SinkRegistry* SinkRegistry::GetSingleton() {
+    static SinkRegistry singleton{};
+    return std::addressof(singleton);
+}
+
+bool SinkRegistry::AttachAnimationGraph(const char* name, RE::BSTEventSink<RE::BSAnimationGraphEvent>* sink,
+                                        RE::Actor* actor, bool sessionScoped) {
+    if (actor == nullptr) {
+        logger::error("No actor to attach {} animation graph sink to.", name);
+        return false;
+    }
+    // Detach through a handle, the actor may be unloaded by the time the sink comes off.
+    return attach(
+        name, sink, actor, sessionScoped, [sink, actor]() { return actor->AddAnimationGraphEventSink(sink); },
+        [sink, handle = actor->GetHandle()]() {
+            if (auto actorPtr = handle.get()) {
+                actorPtr->RemoveAnimationGraphEventSink(sink);
+            }
+        });
+}
+
+bool SinkRegistry::attach(const char* name, const void* sink, const void* source, bool sessionScoped,
+                          const std::function<bool()>& add, std::function<void()> remove) {
+    std::lock_guard<std::mutex> guard(mtx);
+    for (auto const& record : records) {
+        if (record.sink == sink && record.source == source) {
+            LOGTRACE("{} already attached, skipping.", name);
+            return true;
+        }
+    }
+    if (!add()) {
+        logger::error("Failed to attach {} event sink.", name);
+        return false;
+    }
+    records.push_back({name, sink, source, sessionScoped, std::move(remove)});
+
+    for (auto& counter : counters) {
+        auto current = counter.sink.load();
+        if (current == sink) {
+            break;
+        }
+        if (current == nullptr) {
+            counter.name = name;
+            counter.sink.store(sink);
+            break;
+        }
+    }
+    logger::info("{} event sink attached.", name);
+    return true;
+}
+
+void SinkRegistry::Detach(const void* sink) {
+    std::lock_guard<std::mutex> guard(mtx);
+    std::erase_if(records, [sink](Record& record) {
+        if (record.sink != sink) {
+            return false;
+        }
+        record.remove();
+        logger::info("{} event sink detached.", record.name);
+        return true;
+    });
+}
+
+void SinkRegistry::Detach(const void* sink, const void* source) {
+    std::lock_guard<std::mutex> guard(mtx);
+    std::erase_if(records, [sink, source](Record& record) {
+        if (record.sink != sink || record.source != source) {
+            return false;
+        }
+        record.remove();
+        LOGTRACE("{} event sink detached from one source.", record.name);
+        return true;
+    });
+}
+
+void SinkRegistry::DetachSession() {
+    std::lock_guard<std::mutex> guard(mtx);
+    std::erase_if(records, [](Record& record) {
+        if (!record.sessionScoped) {
+            return false;
+        }
+        record.remove();
+        logger::info("{} event sink detached for game state change.", record.name);
+        return true;
+    });
+}
+
+void SinkRegistry::RecordDispatch(const void* sink) {
+    for (auto& counter : counters) {
+        if (counter.sink.load(std::memory_order_relaxed) == sink) {
+            counter.dispatches.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+}
+
+std::uint64_t SinkRegistry::DispatchCount(const void* sink) const {
+    for (auto const& counter : counters) {
+        if (counter.sink.load() == sink) {
+            return counter.dispatches.load();
+        }
+    }
+    return 0;
+}
+
+void SinkRegistry::LogStats() const {
+    std::lock_guard<std::mutex> guard(mtx);
+    for (auto const& counter : counters) {
+        if (counter.sink.load() == nullptr) {
+            break;
+        }
+        auto sink = counter.sink.load();
+        auto attachments = std::ranges::count_if(records, [sink](auto const& record) { return record.sink == sink; });
+        logger::info("{} event sink: {} dispatches, attached to {} sources.", counter.name, counter.dispatches.load(),
+                     attachments);
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "RE/Skyrim.h"
+
+namespace bhh_events {
+    /*
+     * Tracks which event sinks are attached to which sources so attaching twice is a no-op.
+     * Session scoped attachments (player animation graph, race menu) are dropped on game state transitions and
+     * attached again after. Sinks report each dispatch so doubled up registrations show in the logged counts.
+     */
+    class SinkRegistry {
+    public:
+        static constexpr std::size_t maxSinks = 8;
+
+        static SinkRegistry* GetSingleton();
+
+        // Returns true if the sink is attached to the source afterwards, whether or not it already was.
+        template <class Event>
+        bool Attach(const char* name, RE::BSTEventSink<Event>* sink, RE::BSTEventSource<Event>* source,
+                    bool sessionScoped) {
+            if (source == nullptr) {
+                logger::error("No event source to attach {} to.", name);
+                return false;
+            }
+            return attach(
+                name, sink, source, sessionScoped,
+                [sink, source]() {
+                    source->AddEventSink(sink);
+                    return true;
+                },
+                [sink, source]() { source->RemoveEventSink(sink); });
+        }
+        // Animation graph events come from each of the actor's graphs, so the actor stands in as the source.
+        bool AttachAnimationGraph(const char* name, RE::BSTEventSink<RE::BSAnimationGraphEvent>* sink,
+                                  RE::Actor* actor, bool sessionScoped);
+
+        // Detaches the sink from every source it is attached to.
+        void Detach(const void* sink);
+        // Detaches the sink from one source only.
+        void Detach(const void* sink, const void* source);
+        // Detaches every session scoped attachment. Call on game loads and new games.
+        void DetachSession();
+
+        void RecordDispatch(const void* sink);
+        std::uint64_t DispatchCount(const void* sink) const;
+        void LogStats() const;
+
+    private:
+        struct Record {
+            const char* name;
+            const void* sink;
+            const void* source;
+            bool sessionScoped;
+            std::function<void()> remove;
+        };
+        struct Counter {
+            std::atomic<const void*> sink{nullptr};
+            std::atomic<std::uint64_t> dispatches{0};
+            const char* name = nullptr;
+        };
+
+        SinkRegistry() = default;
+        bool attach(const char* name, const void* sink, const void* source, bool sessionScoped,
+                    const std::function<bool()>& add, std::function<void()> remove);
+
+        mutable std::mutex mtx;
+        std::vector<Record> records;
+        // Fixed so dispatch counting never takes the lock.
+        std::array<Counter, maxSinks> counters;
+    };
+}
@@ -0,0 +1,69 @@
+#include "skillxp.hpp"
+
+#include <charconv>
+
+#include "logger.hpp"
+
+using h2h_level::Settings;
+
+std::uint32_t h2h_level::ParseFormID(std::string_view text) {
+    if (text.empty()) {
+        return 0;
+    }
+    if (!text.starts_with("0x") && !text.starts_with("0X")) {
+        logger::warn("Form ID {} needs a 0x prefix, ignoring it.", text);
+        return 0;
+    }
+    std::uint32_t formId = 0;
+    auto const end = text.data() + text.size();
+    if (auto [ptr, ec] = std::from_chars(text.data() + 2, end, formId, 16); ec != std::errc{} || ptr != end) {
+        logger::warn("Form ID {} isn't hex, ignoring it.", text);
+        return 0;
+    }
+    return formId;
+}
+
+float h2h_level::nextSkillLevelXP(float currentLevel, float xpSkillCurve) {
+    return Settings.SkillImproveMult.value * powf(currentLevel, xpSkillCurve) + Settings.SkillImproveOffset.value;
+}
+
+float h2h_level::calcSkillXpGain(float damage) {
+    return Settings.SkillUseMult.value * powf(damage, Settings.DamageXPDampen.value) + Settings.SkillUseOffset.value;
+}
+
+h2h_level::SkillGain h2h_level::addSkillXP(float level, float exp, float xpGain, float xpSkillCurve) {
+    SkillGain gain;
+    gain.level = level;
+    auto xpNeeded = nextSkillLevelXP(level, xpSkillCurve);
+    auto newExp = exp + xpGain;
+    while (newExp >= xpNeeded && gain.level < Settings.SkillMaxLevel) {
+        gain.level += 1.0f;
+        ++gain.levelsGained;
+        gain.levelSum += gain.level;
+        newExp -= xpNeeded;
+        xpNeeded = nextSkillLevelXP(gain.level, xpSkillCurve);
+    }
+    if (gain.level >= Settings.SkillMaxLevel) {
+        return gain;
+    }
+    gain.exp = newExp;
+    gain.ratio = newExp / xpNeeded;
+    return gain;
+}
+
+h2h_level::SkillState h2h_level::MakeSkillState(float level, float exp, float ratio, float showLevelUp,
+                                                float xpSkillCurve) {
+    SkillState state;
+    state.level = level;
+    state.exp = exp;
+    state.ratio = ratio;
+    state.showLevelUp = showLevelUp;
+    if (level < Settings.SkillMaxLevel) {
+        state.xpNeeded = nextSkillLevelXP(level, xpSkillCurve);
+    }
+    return state;
+}
+
+std::vector<float> h2h_level::SkillStateToArray(const SkillState& state) {
+    return {state.level, state.exp, state.ratio, state.xpNeeded, state.showLevelUp};
+}
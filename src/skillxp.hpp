@@ -0,0 +1,105 @@
+#pragma once
+
+/*
+ * Hand to hand skill math and settings. Plain values only, nothing here touches the game.
+ */
+namespace h2h_level {
+
+    struct SettingVal {
+        const char* name;
+        const float min, max, regular;
+        float value;
+        SettingVal(const char* nameGiven, float minGiven, float maxGiven, float regGiven)
+            : name(nameGiven), min(minGiven), max(maxGiven), regular(regGiven), value(regGiven) {}
+    };
+
+    /*
+     * Settings with an in game equivalent.
+     */
+    struct SettingsValues {
+        SettingVal SkillUseMult{"SkillUseMult", 0.0f, 100.f, 6.6f};
+        SettingVal SkillUseOffset{"SkillUseOffset", 0.0f, 100.f, 1.0f};
+        SettingVal SkillImproveMult{"SkillImproveMult", 0.0f, 100.f, 2.0f};
+        SettingVal SkillImproveOffset{"SkillImproveOffset", 0.0f, 100.f, 0.0f};
+        /*
+         * Normal melee skills go off the base damage of the weapon dealt to target.
+         * Normally the player can get higher tier weapons to keep leveling up, but they can't change their hands.
+         * As such we calculate the damage as the unarmed damage with all perks applied, but dampen the effect a bit by
+         * exponenentiating it to this value.
+         */
+        SettingVal DamageXPDampen{"DamageXPDampen", 0.0f, 2.f, 0.91f};
+
+        /*
+         * Diminishing returns on hitting the same defender over and over.
+         * Each recent hit on a defender scales XP by (1 - PenaltyPerHit), recent hits fade with HalfLifeSeconds and
+         * XP never drops under MinMultiplier. Capacity is how many defenders are remembered at once.
+         */
+        SettingVal DRCapacity{"Capacity", 0.0f, 65536.f, 1024.f};
+        SettingVal DRHalfLife{"HalfLifeSeconds", 0.1f, 3600.f, 30.f};
+        SettingVal DRPenaltyPerHit{"PenaltyPerHit", 0.0f, 1.f, 0.05f};
+        SettingVal DRMinMultiplier{"MinMultiplier", 0.0f, 1.f, 0.25f};
+
+        /*
+         * Hits on the same target from the same source within DedupeWindowMs of each other count as one hit.
+         * With DedupeSliding on, every suppressed hit restarts the window.
+         */
+        SettingVal DedupeWindowMs{"WindowMs", 0.0f, 1000.f, 100.f};
+        SettingVal DedupeSliding{"Sliding", 0.0f, 1.f, 0.0f};
+
+        /*
+         * Player level experience is written straight into the player's skill data on the main thread. The grant that
+         * reaches the level threshold still goes through papyrus so the game handles the level up itself.
+         * Set to 0 to go back to the papyrus Game.GetPlayerExperience/SetPlayerExperience calls.
+         */
+        SettingVal NativePlayerXP{"UseNative", 0.0f, 1.f, 1.0f};
+
+        /*
+         * Where to find BHH_RotateAttacksFaction for NPC attack rotation, as the plugin name and the faction's form ID
+         * within it. Vanilla doesn't keep editor IDs for factions, so without these the lookup by editor ID only works
+         * when another plugin keeps editor IDs loaded.
+         */
+        std::string RotateFactionPlugin;
+        std::uint32_t RotateFactionFormID = 0;
+
+        // Max Hand To Hand Level
+        const float SkillMaxLevel = 100.0f;
+    };
+    // One instance shared by every translation unit, so values loaded from the ini are seen everywhere.
+    inline SettingsValues Settings;
+    // Form ID setting, hex with a 0x prefix so one copied without it isn't quietly read as decimal. 0 if empty or
+    // malformed.
+    std::uint32_t ParseFormID(std::string_view text);
+
+    // Formula used by the game to calculate amount of skill points needed for the next level
+    float nextSkillLevelXP(float currentLevel, float xpSkillCurve);
+    // Formula used by gain to calculate how much skill XP to give for this attack
+    float calcSkillXpGain(float damage);
+
+    // Skill values after some XP was added.
+    struct SkillGain {
+        float level = 0.0f;
+        float exp = 0.0f;
+        float ratio = 0.0f;
+        int levelsGained = 0;
+        // Sum of every level reached, the game gives fXPPerSkillRank player experience per level.
+        float levelSum = 0.0f;
+    };
+    // Adds XP to a skill the way the game does, levelling as many times as it fills. Exp and ratio are 0 at max level.
+    SkillGain addSkillXP(float level, float exp, float xpGain, float xpSkillCurve);
+
+    /*
+     * Snapshot of the hand to hand skill globals. Lets scripts read everything in one native call instead of polling
+     * each global.
+     */
+    struct SkillState {
+        float level = 0.0f;
+        float exp = 0.0f;
+        float ratio = 0.0f;
+        float xpNeeded = 0.0f;
+        float showLevelUp = 0.0f;
+    };
+    // Builds a snapshot from the global values. xpNeeded stays 0 once the skill is maxed.
+    SkillState MakeSkillState(float level, float exp, float ratio, float showLevelUp, float xpSkillCurve);
+    // Flattens a skill state into the array layout handed back to papyrus: level, exp, ratio, xpNeeded, showLevelUp.
+    std::vector<float> SkillStateToArray(const SkillState& state);
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "ringqueue.hpp"
+
+namespace bhh_events {
+    /*
+     * Items waiting to be handled together on another thread, usually the main thread through one reusable task.
+     * Push says when the owner has to schedule a drain, which is only when none is pending already, so a burst of
+     * items costs a single task. Preallocated, pushing and draining never allocate.
+     */
+    template <class T, std::size_t N>
+    class TaskBatch {
+    public:
+        enum class PushResult {
+            // Added, a drain is already scheduled and will pick it up.
+            kQueued,
+            // Added, the caller has to schedule a drain.
+            kScheduleDrain,
+            // Dropped, the batch is full.
+            kFull
+        };
+
+        PushResult Push(T item) {
+            std::lock_guard<std::mutex> guard(mtx);
+            if (!items.TryPush(std::move(item))) {
+                return PushResult::kFull;
+            }
+            if (scheduled) {
+                return PushResult::kQueued;
+            }
+            scheduled = true;
+            return PushResult::kScheduleDrain;
+        }
+
+        // Hands every queued item to func, including ones pushed while draining. The lock isn't held during func.
+        template <class Func>
+        void Drain(Func&& func) {
+            while (true) {
+                std::unique_lock<std::mutex> lck(mtx);
+                auto item = items.TryPop();
+                if (!item) {
+                    scheduled = false;
+                    return;
+                }
+                lck.unlock();
+                func(*item);
+            }
+        }
+
+    private:
+        std::mutex mtx;
+        RingQueue<T, N> items;
+        bool scheduled = false;
+    };
+}
@@ -0,0 +1,62 @@
+#include "xpdecay.hpp"
+
+#include "logger.hpp"
+
+using h2h_level::DiminishingReturns;
+
+void DiminishingReturns::Configure(std::size_t capacity, float halfLifeSeconds, float penaltyPerHit,
+                                   float minMultiplier) {
+    halfLife = halfLifeSeconds;
+    penalty = penaltyPerHit;
+    minMult = minMultiplier;
+    evictions = 0;
+    if (capacity == 0 || penalty <= 0.0f) {
+        entries.clear();
+        entries.shrink_to_fit();
+        setMask = 0;
+        logger::info("XP diminishing returns disabled.");
+        return;
+    }
+    auto sets = std::bit_ceil((capacity + ways - 1) / ways);
+    setMask = sets - 1;
+    entries.assign(sets * ways, Entry{});
+    logger::info("XP diminishing returns tracking {} defenders.", entries.size());
+}
+
+float DiminishingReturns::RecordHit(RE::FormID defender, Clock::time_point now) {
+    if (entries.empty() || defender == 0) {
+        return 1.0f;
+    }
+    // Fibonacci hash, FormIDs share their high load order byte so mix it back into the low bits.
+    auto hash = static_cast<std::uint32_t>(defender * 2654435761u);
+    hash ^= hash >> 16;
+    auto set = entries.data() + (hash & setMask) * ways;
+
+    auto victim = set;
+    for (auto entry = set; entry != set + ways; ++entry) {
+        if (entry->formId == defender) {
+            if (halfLife > 0.0f) {
+                auto elapsed = std::chrono::duration<float>(now - entry->lastHit).count();
+                entry->fatigue *= std::exp2(-elapsed / halfLife);
+            }
+            auto mult = std::max(minMult, std::pow(1.0f - penalty, entry->fatigue));
+            entry->fatigue += 1.0f;
+            entry->lastHit = now;
+            return mult;
+        }
+        // Prefer an empty way, otherwise the least recently hit one.
+        if (victim->formId != 0 && (entry->formId == 0 || entry->lastHit < victim->lastHit)) {
+            victim = entry;
+        }
+    }
+    if (victim->formId != 0) {
+        ++evictions;
+    }
+    *victim = Entry{defender, 1.0f, now};
+    return 1.0f;
+}
+
+void DiminishingReturns::Clear() {
+    std::fill(entries.begin(), entries.end(), Entry{});
+    evictions = 0;
+}
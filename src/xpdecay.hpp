@@ -0,0 +1,39 @@
+#pragma once
+#include "RE/Skyrim.h"
+
+namespace h2h_level {
+    /*
+     * Diminishing returns for repeatedly hitting the same defender, to stop XP farming on dummies and paralyzed NPCs.
+     * Each defender carries a fatigue value that grows by one per hit and halves every half life. XP is scaled by
+     * (1 - penaltyPerHit)^fatigue, never going under minMultiplier.
+     * Storage is a fixed set associative table allocated in Configure. A FormID hashes to one set of ways and a miss
+     * replaces the least recently hit way, so lookups are bounded and never allocate.
+     */
+    class DiminishingReturns {
+    public:
+        using Clock = std::chrono::steady_clock;
+        static constexpr std::size_t ways = 8;
+
+        // Capacity is rounded up to a power of two number of sets. A capacity or penalty of 0 disables tracking.
+        void Configure(std::size_t capacity, float halfLifeSeconds, float penaltyPerHit, float minMultiplier);
+        // Records a hit on the defender and returns the XP multiplier for it.
+        float RecordHit(RE::FormID defender, Clock::time_point now);
+        void Clear();
+
+        std::size_t Capacity() const { return entries.size(); }
+        std::uint64_t Evictions() const { return evictions; }
+
+    private:
+        struct Entry {
+            RE::FormID formId = 0;
+            float fatigue = 0.0f;
+            Clock::time_point lastHit{};
+        };
+        std::vector<Entry> entries;
+        std::size_t setMask = 0;
+        float halfLife = 0.0f;
+        float penalty = 0.0f;
+        float minMult = 1.0f;
+        std::uint64_t evictions = 0;
+    };
+}
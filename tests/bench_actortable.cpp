@@ -0,0 +1,47 @@
+#include <cstdio>
+#include <random>
+
+#include "rotationtable.hpp"
+
+/*
+ * Per animation event cost of the attack rotation sink against how many actors are tracked. The sink is only attached
+ * to tracked actors, so every event gets the shared lookup and most stop there or at the tag check in Toggle.
+ */
+int main() {
+    using Clock = bhh_events::RotationTable::Clock;
+    constexpr int events = 2'000'000;
+    static constexpr std::string_view tags[] = {"weaponSwing", "AttackWinStart", "FootLeft", "attackStop",
+                                                "preHitFrame", "SoundPlay.NPCHumanCombatShieldBash"};
+    constexpr RE::FormID firstNpc = 0xFF000800;
+    RE::Actor actor;
+    bhh_events::RotationTable actors;
+
+    for (std::uint32_t tracked : {1u, 16u, 128u, 512u, 768u}) {
+        actors.Clear();
+        for (std::uint32_t i = 0; i < tracked; ++i) {
+            actors.Track(firstNpc + i * 13, actor.GetHandle(), &actor);
+        }
+        std::mt19937 rng(tracked);
+        std::vector<RE::FormID> senders(events);
+        for (auto& sender : senders) {
+            sender = firstNpc + (rng() % tracked) * 13;
+        }
+
+        // A fight's worth of events per millisecond, so the debounce window opens and closes as it would in game.
+        auto now = Clock::now();
+        int toggles = 0;
+        auto begin = Clock::now();
+        for (int i = 0; i < events; ++i) {
+            if (i % 64 == 0) {
+                now += std::chrono::milliseconds(1);
+            }
+            if (actors.WantsEvent(senders[i], now) &&
+                actors.Toggle(senders[i], tags[i % std::size(tags)], "AttackStartH2HLeft", false, now) != 0.0f) {
+                ++toggles;
+            }
+        }
+        auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - begin).count();
+        std::printf("tracked %4u  %6.1f ns/event  (%d toggles)\n", tracked, elapsed / events, toggles);
+    }
+    return 0;
+}
@@ -0,0 +1,161 @@
+#include <cstdio>
+#include <future>
+#include <queue>
+
+#include "playerxp.hpp"
+#include "taskbatch.hpp"
+
+/*
+ * The native and papyrus routes for player level experience, both as the XP worker sees them. The fake game runs one
+ * frame at a time like the real one: each frame it answers queued papyrus calls and drains the native grant batch.
+ * Reports how long the worker spends per grant and how long until the new value is in place.
+ */
+namespace {
+    using Clock = std::chrono::steady_clock;
+    using h2h_level::PlayerXP;
+    using h2h_level::PlayerXPStore;
+
+    class NativeStore : public PlayerXPStore {
+    public:
+        std::optional<PlayerXP> Read() override { return value; }
+        bool Write(float xp) override {
+            value.xp = xp;
+            return true;
+        }
+        PlayerXP value{0.0f, 1e9f};
+    };
+
+    // Native grants waiting for the main thread, as the plugin queues them.
+    struct NativeGrant {
+        float xpGained;
+        Clock::time_point queued;
+    };
+
+    using GrantBatch = bhh_events::TaskBatch<NativeGrant, 64>;
+
+    class FakeGame {
+    public:
+        explicit FakeGame(std::chrono::microseconds frameGiven) : frame(frameGiven), thread([this]() { run(); }) {}
+        ~FakeGame() {
+            {
+                std::lock_guard<std::mutex> guard(mtx);
+                stopping = true;
+            }
+            thread.join();
+        }
+
+        // A papyrus call, answered on the next frame.
+        std::future<float> Call(std::function<float()> call) {
+            std::packaged_task<float()> task(std::move(call));
+            auto result = task.get_future();
+            std::lock_guard<std::mutex> guard(mtx);
+            calls.push(std::move(task));
+            return result;
+        }
+
+        // Queues a native grant. Drained every frame, so there is no drain task to schedule.
+        bool Grant(float xpGained) {
+            return nativeGrants.Push({xpGained, Clock::now()}) != GrantBatch::PushResult::kFull;
+        }
+
+        // Total time between queueing and applying native grants, and how many were applied.
+        std::pair<Clock::duration, int> NativeApplied() {
+            std::lock_guard<std::mutex> guard(mtx);
+            return {nativeDelay, nativeCount};
+        }
+
+        NativeStore native;
+
+    private:
+        void run() {
+            while (true) {
+                std::this_thread::sleep_for(frame);
+                std::lock_guard<std::mutex> guard(mtx);
+                while (!calls.empty()) {
+                    calls.front()();
+                    calls.pop();
+                }
+                nativeGrants.Drain([this](NativeGrant& grant) {
+                    h2h_level::GrantPlayerXP(native, grant.xpGained);
+                    nativeDelay += Clock::now() - grant.queued;
+                    ++nativeCount;
+                });
+                if (stopping) {
+                    return;
+                }
+            }
+        }
+
+        std::chrono::microseconds frame;
+        std::mutex mtx;
+        std::queue<std::packaged_task<float()>> calls;
+        GrantBatch nativeGrants;
+        Clock::duration nativeDelay{};
+        int nativeCount = 0;
+        bool stopping = false;
+        std::thread thread;
+    };
+
+    class VMStore : public PlayerXPStore {
+    public:
+        explicit VMStore(FakeGame& gameGiven) : game(gameGiven) {}
+        std::optional<PlayerXP> Read() override {
+            return PlayerXP{game.Call([this]() { return xp; }).get(), 0.0f};
+        }
+        bool Write(float newXP) override {
+            game.Call([this, newXP]() { return xp = newXP; }).get();
+            return true;
+        }
+        float xp = 0.0f;
+
+    private:
+        FakeGame& game;
+    };
+
+    double toUs(Clock::duration duration) { return std::chrono::duration<double, std::micro>(duration).count(); }
+
+    // Grants spaced out like skill level ups during a fight, a few frames apart.
+    constexpr int grants = 10;
+
+    void benchNative(std::chrono::microseconds frame) {
+        FakeGame game(frame);
+        Clock::duration workerTime{};
+        for (int i = 0; i < grants; ++i) {
+            auto begin = Clock::now();
+            game.Grant(15.0f);
+            workerTime += Clock::now() - begin;
+            std::this_thread::sleep_for(frame * 3);
+        }
+        auto [delay, applied] = game.NativeApplied();
+        while (applied < grants) {
+            std::this_thread::sleep_for(frame);
+            std::tie(delay, applied) = game.NativeApplied();
+        }
+        std::printf("native  %5lld us frames  worker %10.2f us/grant  applied after %10.1f us\n",
+                    static_cast<long long>(frame.count()), toUs(workerTime) / grants, toUs(delay) / grants);
+    }
+
+    void benchPapyrus(std::chrono::microseconds frame) {
+        FakeGame game(frame);
+        VMStore store(game);
+        Clock::duration workerTime{};
+        for (int i = 0; i < grants; ++i) {
+            auto begin = Clock::now();
+            h2h_level::GrantPlayerXP(store, 15.0f);
+            workerTime += Clock::now() - begin;
+            std::this_thread::sleep_for(frame * 3);
+        }
+        // The worker waits on the set, so the value is in place when the grant returns.
+        std::printf("papyrus %5lld us frames  worker %10.2f us/grant  applied after %10.1f us\n",
+                    static_cast<long long>(frame.count()), toUs(workerTime) / grants, toUs(workerTime) / grants);
+    }
+}
+
+int main() {
+    // 60 fps frames and a faster game, both far slower than writing the value.
+    for (auto frame : {std::chrono::microseconds(16667), std::chrono::microseconds(2000)}) {
+        benchNative(frame);
+        benchPapyrus(frame);
+    }
+    return 0;
+}
@@ -0,0 +1,36 @@
+#include <cstdio>
+#include <random>
+
+#include "xpdecay.hpp"
+
+using h2h_level::DiminishingReturns;
+
+// Cost of RecordHit while thousands of defenders churn through a table much smaller than them.
+int main() {
+    constexpr std::size_t capacity = 1024;
+    constexpr int hits = 2'000'000;
+
+    for (std::uint32_t defenders : {512u, 2048u, 8192u, 32768u}) {
+        DiminishingReturns dr;
+        dr.Configure(capacity, 30.0f, 0.05f, 0.25f);
+        // Skewed like a real fight, a few defenders take most of the hits.
+        std::mt19937 rng(defenders);
+        std::geometric_distribution<std::uint32_t> pick(4.0 / defenders);
+        std::vector<RE::FormID> ids(hits);
+        for (auto& id : ids) {
+            id = 0xFF000800 + pick(rng) % defenders;
+        }
+
+        auto now = DiminishingReturns::Clock::time_point{};
+        float sink = 0.0f;
+        auto begin = std::chrono::steady_clock::now();
+        for (auto id : ids) {
+            now += std::chrono::milliseconds(5);
+            sink += dr.RecordHit(id, now);
+        }
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+        std::printf("defenders %6u  capacity %zu  %6.1f ns/hit  %8.4f%% evicting  (%g)\n", defenders, dr.Capacity(),
+                    elapsed / hits, 100.0 * dr.Evictions() / hits, sink);
+    }
+    return 0;
+}
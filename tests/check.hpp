@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+// Minimal checks so the tests don't need a framework. The first failure prints and exits non zero.
+#define CHECK(cond)                                                                       \
+    do {                                                                                  \
+        if (!(cond)) {                                                                    \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            std::exit(1);                                                                 \
+        }                                                                                 \
+    } while (0)
+
+#define CHECK_NEAR(actual, expected, eps)                                                                     \
+    do {                                                                                                      \
+        double const a_ = (actual), e_ = (expected);                                                          \
+        if (std::fabs(a_ - e_) > (eps)) {                                                                     \
+            std::fprintf(stderr, "%s:%d: %s = %f, expected %f\n", __FILE__, __LINE__, #actual, a_, e_);      \
+            std::exit(1);                                                                                     \
+        }                                                                                                     \
+    } while (0)
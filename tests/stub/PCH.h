@@ -0,0 +1,40 @@
+#pragma once
+
+// Stand in for src/PCH.h when building tests without CommonLibSSE.
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include "RE/Skyrim.h"
+#include "SKSE/SKSE.h"
+
+using namespace std::literals;
+
+// Log calls are type checked but go nowhere.
+namespace logger {
+    template <class... Args>
+    void trace(Args&&...) {}
+    template <class... Args>
+    void info(Args&&...) {}
+    template <class... Args>
+    void warn(Args&&...) {}
+    template <class... Args>
+    void error(Args&&...) {}
+}
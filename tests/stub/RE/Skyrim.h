@@ -0,0 +1,88 @@
+#pragma once
+
+// Just enough of CommonLibSSE for the plugin code under test. Event sources are fakes that dispatch synchronously.
+namespace RE {
+    using FormID = std::uint32_t;
+
+    enum class BSEventNotifyControl { kContinue, kStop };
+
+    template <class Event>
+    class BSTEventSource;
+
+    template <class Event>
+    class BSTEventSink {
+    public:
+        virtual ~BSTEventSink() = default;
+        virtual BSEventNotifyControl ProcessEvent(const Event* event, BSTEventSource<Event>* source) = 0;
+    };
+
+    // Unlike the game's, adding a sink twice really registers it twice, so doubled attachments show up.
+    template <class Event>
+    class BSTEventSource {
+    public:
+        void AddEventSink(BSTEventSink<Event>* sink) { sinks.push_back(sink); }
+        void RemoveEventSink(BSTEventSink<Event>* sink) {
+            if (auto it = std::ranges::find(sinks, sink); it != sinks.end()) {
+                sinks.erase(it);
+            }
+        }
+        void SendEvent(const Event* event) {
+            for (auto sink : sinks) {
+                if (sink->ProcessEvent(event, this) == BSEventNotifyControl::kStop) {
+                    break;
+                }
+            }
+        }
+        std::size_t SinkCount() const { return sinks.size(); }
+
+    private:
+        std::vector<BSTEventSink<Event>*> sinks;
+    };
+
+    struct BSAnimationGraphEvent {
+        const char* tag = "";
+    };
+
+    template <class T>
+    class NiPointer {
+    public:
+        NiPointer(T* ptrGiven = nullptr) : ptr(ptrGiven) {}
+        T* get() const { return ptr; }
+        T* operator->() const { return ptr; }
+        explicit operator bool() const { return ptr != nullptr; }
+
+    private:
+        T* ptr;
+    };
+
+    class Actor;
+    // Only ever passed around by pointer.
+    class TESObjectWEAP;
+
+    // Resolves to nothing once the actor is unloaded.
+    class ActorHandle {
+    public:
+        ActorHandle() = default;
+        explicit ActorHandle(Actor* actorGiven) : actor(actorGiven) {}
+        NiPointer<Actor> get() const;
+
+    private:
+        Actor* actor = nullptr;
+    };
+
+    // An actor with a single animation graph.
+    class Actor {
+    public:
+        bool AddAnimationGraphEventSink(BSTEventSink<BSAnimationGraphEvent>* sink) {
+            graph.AddEventSink(sink);
+            return true;
+        }
+        void RemoveAnimationGraphEventSink(BSTEventSink<BSAnimationGraphEvent>* sink) { graph.RemoveEventSink(sink); }
+        ActorHandle GetHandle() { return ActorHandle(this); }
+
+        BSTEventSource<BSAnimationGraphEvent> graph;
+        bool loaded = true;
+    };
+
+    inline NiPointer<Actor> ActorHandle::get() const { return actor != nullptr && actor->loaded ? actor : nullptr; }
+}
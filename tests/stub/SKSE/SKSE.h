@@ -0,0 +1,52 @@
+#pragma once
+
+// Just enough of SKSE's task interface to run main thread tasks in tests. Nothing here allocates.
+namespace SKSE {
+    namespace detail {
+        class TaskDelegate {
+        public:
+            virtual ~TaskDelegate() = default;
+            virtual void Run() = 0;
+            virtual void Dispose() = 0;
+        };
+    }
+
+    // Holds queued tasks until the test runs a frame of the fake main thread with RunPending.
+    class TaskInterface {
+    public:
+        void AddTask(detail::TaskDelegate* task) const {
+            std::lock_guard<std::mutex> guard(mtx);
+            if (count == pending.size()) {
+                std::fprintf(stderr, "Stub task interface full\n");
+                std::abort();
+            }
+            pending[count++] = task;
+        }
+
+        // Runs and disposes every task queued before the call. Returns how many ran.
+        std::size_t RunPending() const {
+            std::array<detail::TaskDelegate*, 64> running;
+            std::size_t ran;
+            {
+                std::lock_guard<std::mutex> guard(mtx);
+                running = pending;
+                ran = std::exchange(count, 0);
+            }
+            for (std::size_t i = 0; i < ran; ++i) {
+                running[i]->Run();
+                running[i]->Dispose();
+            }
+            return ran;
+        }
+
+    private:
+        mutable std::mutex mtx;
+        mutable std::array<detail::TaskDelegate*, 64> pending{};
+        mutable std::size_t count = 0;
+    };
+
+    inline const TaskInterface* GetTaskInterface() {
+        static TaskInterface tasks;
+        return &tasks;
+    }
+}
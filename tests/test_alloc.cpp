@@ -0,0 +1,235 @@
+#include <cstddef>
+#include <cstdio>
+#include <new>
+
+#include "check.hpp"
+#include "hitqueue.hpp"
+#include "lifecycle.hpp"
+#include "maintask.hpp"
+#include "rotationtable.hpp"
+#include "sinkregistry.hpp"
+#include "skillxp.hpp"
+#include "xpdecay.hpp"
+
+/*
+ * Replays a combat event stream through the same pieces the hit and animation sinks call, with every heap allocation
+ * counted. Setup may allocate, the stream itself must not.
+ */
+namespace {
+    std::atomic<bool> counting = false;
+    std::atomic<std::size_t> allocations = 0;
+
+    void* countedAlloc(std::size_t size, std::size_t alignment = 0) noexcept {
+        if (counting.load(std::memory_order_relaxed)) {
+            allocations.fetch_add(1, std::memory_order_relaxed);
+        }
+        size = size == 0 ? 1 : size;
+        if (alignment <= alignof(std::max_align_t)) {
+            return std::malloc(size);
+        }
+        // aligned_alloc wants the size to be a multiple of the alignment.
+        return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    }
+
+    void* countedAllocOrThrow(std::size_t size, std::size_t alignment = 0) {
+        if (auto ptr = countedAlloc(size, alignment)) {
+            return ptr;
+        }
+        throw std::bad_alloc();
+    }
+}
+
+void* operator new(std::size_t size) { return countedAllocOrThrow(size); }
+void* operator new[](std::size_t size) { return countedAllocOrThrow(size); }
+void* operator new(std::size_t size, std::align_val_t al) { return countedAllocOrThrow(size, std::size_t(al)); }
+void* operator new[](std::size_t size, std::align_val_t al) { return countedAllocOrThrow(size, std::size_t(al)); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+void* operator new(std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return countedAlloc(size, std::size_t(al));
+}
+void* operator new[](std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return countedAlloc(size, std::size_t(al));
+}
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { std::free(ptr); }
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct CombatEvent {
+        enum class Kind { kEnterCombat, kHit, kAnimation, kLeaveCombat } kind;
+        RE::FormID actor;
+        RE::FormID source;
+        std::string_view tag;
+        std::string_view attackEvent;
+        bool isPower;
+        Clock::time_point when;
+    };
+
+    // Stand ins for the papyrus event and the faction rank change at the end of each main thread task.
+    int levelUpEvents = 0, rankChanges = 0;
+    void sendLevelUp(float&) { ++levelUpEvents; }
+    struct RankUpdate {
+        RE::FormID actor;
+        std::int8_t rank;
+    };
+    void applyRank(RankUpdate&) { ++rankChanges; }
+
+    // Stored through a volatile so the optimizer can't drop a new and delete pair.
+    void* volatile escaped = nullptr;
+    template <class T>
+    T* escape(T* ptr) {
+        escaped = ptr;
+        return ptr;
+    }
+
+    struct HitSink : RE::BSTEventSink<RE::BSAnimationGraphEvent> {
+        RE::BSEventNotifyControl ProcessEvent(const RE::BSAnimationGraphEvent*,
+                                              RE::BSTEventSource<RE::BSAnimationGraphEvent>*) override {
+            return RE::BSEventNotifyControl::kContinue;
+        }
+    };
+
+    std::vector<CombatEvent> makeStream() {
+        static constexpr std::string_view tags[] = {"AttackWinStart", "attackStop", "preHitFrame", "weaponSwing"};
+        static constexpr std::string_view attacks[] = {"AttackStartH2HRight", "AttackStartH2HLeft",
+                                                       "attackPowerStartForwardH2HRightHand",
+                                                       "attackPowerStartH2HCombo"};
+        std::vector<CombatEvent> stream;
+        auto now = Clock::time_point{};
+        constexpr RE::FormID firstNpc = 0xFF000800;
+        constexpr int npcs = 40;
+        for (int npc = 0; npc < npcs; ++npc) {
+            stream.push_back({CombatEvent::Kind::kEnterCombat, firstNpc + npc, 0, {}, {}, false, now});
+        }
+        for (int i = 0; i < 20000; ++i) {
+            now += std::chrono::milliseconds(7);
+            RE::FormID target = firstNpc + (i * 7) % npcs;
+            // Each punch raises a hit for the fist and one for its enchantment, sometimes doubled up.
+            stream.push_back({CombatEvent::Kind::kHit, target, 0x1F4, {}, {}, false, now});
+            stream.push_back({CombatEvent::Kind::kHit, target, 0x10F9A2, {}, {}, false, now});
+            if (i % 3 == 0) {
+                stream.push_back({CombatEvent::Kind::kHit, target, 0x1F4, {}, {}, false, now});
+            }
+            auto attacker = i % 2 == 0 ? 0x14 : firstNpc + i % npcs;
+            stream.push_back({CombatEvent::Kind::kAnimation, attacker, 0, tags[i % 4], attacks[i % 4], i % 4 == 2,
+                              now});
+        }
+        for (int npc = 0; npc < npcs; ++npc) {
+            stream.push_back({CombatEvent::Kind::kLeaveCombat, firstNpc + npc, 0, {}, {}, false, now});
+        }
+        return stream;
+    }
+}
+
+int main() {
+    // Setup, allocating is fine here.
+    auto stream = makeStream();
+    HitSink sink;
+    RE::Actor player, npc;
+    auto registry = bhh_events::SinkRegistry::GetSingleton();
+    CHECK(registry->AttachAnimationGraph("AllocHarness", &sink, &player, false));
+    auto tasks = SKSE::GetTaskInterface();
+    bhh_events::HitQueue hits;
+    hits.Configure(100ms, false);
+    h2h_level::DiminishingReturns decay;
+    decay.Configure(1024, 30.0f, 0.05f, 0.25f);
+    bhh_events::RotationTable actors;
+    actors.Track(0x14, player.GetHandle(), &player);
+    bhh_events::MainThreadTask<float, 16> levelUpTask("Level up event", sendLevelUp);
+    bhh_events::MainThreadTask<RankUpdate, 64> rankTask("NPC attack rotation", applyRank);
+
+    float level = 15.0f, exp = 0.0f, playerXP = 0.0f;
+    int hitsProcessed = 0, duplicates = 0;
+
+    counting = true;
+    for (auto const& event : stream) {
+        registry->RecordDispatch(&sink);
+        switch (event.kind) {
+        case CombatEvent::Kind::kEnterCombat:
+            actors.Track(event.actor, npc.GetHandle(), &npc);
+            break;
+        case CombatEvent::Kind::kLeaveCombat:
+            actors.Untrack(event.actor);
+            break;
+        case CombatEvent::Kind::kHit: {
+            // Main thread side, HitEventHandler::ProcessEvent.
+            if (hits.IsDuplicate(event.actor, event.source, event.when)) {
+                ++duplicates;
+                break;
+            }
+            CHECK(hits.Push(npc.GetHandle(), nullptr));
+            // Worker side, HitEventHandler::workerLoop.
+            auto job = hits.Pop();
+            if (!job.ticket.IsCurrent()) {
+                break;
+            }
+            auto xpGain = h2h_level::calcSkillXpGain(12.0f) * decay.RecordHit(event.actor, event.when);
+            auto gain = h2h_level::addSkillXP(level, exp, xpGain, 1.95f);
+            for (int i = 1; i <= gain.levelsGained; ++i) {
+                if (!levelUpTask.Push(level + static_cast<float>(i))) {
+                    break;
+                }
+            }
+            level = gain.level;
+            exp = gain.exp;
+            playerXP += gain.levelSum * 15.0f;
+            ++hitsProcessed;
+            break;
+        }
+        case CombatEvent::Kind::kAnimation: {
+            // AnimHandler::ProcessEvent, less the game lookups in between.
+            if (!actors.WantsEvent(event.actor, event.when)) {
+                break;
+            }
+            auto rotation = actors.Toggle(event.actor, event.tag, event.attackEvent, event.isPower, event.when);
+            if (rotation != 0.0f && event.actor != 0x14) {
+                rankTask.Push({event.actor, static_cast<std::int8_t>(rotation > 0.0f ? 1 : 0)});
+            }
+            break;
+        }
+        }
+        // One game frame per event, running whatever the sinks and worker queued for the main thread.
+        tasks->RunPending();
+    }
+    counting = false;
+
+    std::printf("%zu events, %d hits, %d level ups, %d rotation changes, %zu allocations\n", stream.size(),
+                hitsProcessed, levelUpEvents, rankChanges, allocations.load());
+    // Make sure the stream actually went down every path.
+    CHECK(hitsProcessed > 0);
+    CHECK(levelUpEvents > 0);
+    CHECK(rankChanges > 0);
+    CHECK(duplicates > 0);
+    CHECK(actors.Size() == 1);
+    CHECK(registry->DispatchCount(&sink) == stream.size());
+    CHECK(allocations.load() == 0);
+
+    // The counting has to see every form of new, or the zero above means nothing.
+    struct alignas(64) Wide {
+        char bytes[64];
+    };
+    counting = true;
+    delete escape(new int);
+    delete escape(new (std::nothrow) int);
+    delete[] escape(new int[2]);
+    delete[] escape(new (std::nothrow) int[2]);
+    delete escape(new Wide);
+    delete escape(new (std::nothrow) Wide);
+    delete[] escape(new Wide[2]);
+    delete[] escape(new (std::nothrow) Wide[2]);
+    counting = false;
+    CHECK(allocations.load() == 8);
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include <map>
+#include <random>
+
+#include "check.hpp"
+#include "formidtable.hpp"
+
+using bhh_events::FormIDTable;
+
+namespace {
+    using Table = FormIDTable<int, 64>;
+
+    void checkMatches(Table& table, const std::map<RE::FormID, int>& expected, RE::FormID range) {
+        CHECK(table.Size() == expected.size());
+        for (RE::FormID id = 1; id <= range; ++id) {
+            auto found = table.Find(id);
+            auto it = expected.find(id);
+            CHECK((found != nullptr) == (it != expected.end()));
+            if (found != nullptr) {
+                CHECK(*found == it->second);
+            }
+        }
+    }
+
+    void testBasics() {
+        Table table;
+        CHECK(table.Find(0x14) == nullptr);
+        CHECK(table.Insert(0) == nullptr);
+        auto value = table.Insert(0x14);
+        CHECK(value != nullptr && *value == 0);
+        *value = 5;
+        CHECK(table.Insert(0x14) == value);
+        CHECK(*table.Find(0x14) == 5);
+        CHECK(table.Erase(0x14));
+        CHECK(!table.Erase(0x14));
+        CHECK(table.Find(0x14) == nullptr);
+
+        for (RE::FormID id = 1; id <= Table::maxEntries; ++id) {
+            CHECK(table.Insert(id) != nullptr);
+        }
+        CHECK(table.Insert(Table::maxEntries + 1) == nullptr);
+        // Existing entries are still found when full.
+        CHECK(table.Insert(1) != nullptr);
+    }
+
+    void testRandomAgainstMap() {
+        // Few distinct ids in a small table so probe runs collide and wrap.
+        constexpr RE::FormID range = 200;
+        Table table;
+        std::map<RE::FormID, int> expected;
+        std::mt19937 rng(7);
+        for (int step = 0; step < 20000; ++step) {
+            RE::FormID id = rng() % range + 1;
+            if (rng() % 2 == 0) {
+                if (auto value = table.Insert(id)) {
+                    *value = step;
+                    expected[id] = step;
+                } else {
+                    CHECK(expected.size() >= Table::maxEntries);
+                }
+            } else {
+                CHECK(table.Erase(id) == (expected.erase(id) == 1));
+            }
+            if (step % 500 == 0) {
+                checkMatches(table, expected, range);
+            }
+        }
+        checkMatches(table, expected, range);
+    }
+
+    void testEraseIf() {
+        constexpr RE::FormID range = 200;
+        std::mt19937 rng(11);
+        for (int round = 0; round < 200; ++round) {
+            Table table;
+            std::map<RE::FormID, int> expected;
+            while (expected.size() < Table::maxEntries) {
+                RE::FormID id = rng() % range + 1;
+                *table.Insert(id) = static_cast<int>(id);
+                expected[id] = static_cast<int>(id);
+            }
+            auto stale = [round](RE::FormID id) { return (id + round) % 3 == 0; };
+            auto erased = table.EraseIf([&stale](RE::FormID id, int&) { return stale(id); });
+            CHECK(erased == std::erase_if(expected, [&stale](auto const& entry) { return stale(entry.first); }));
+            checkMatches(table, expected, range);
+        }
+    }
+}
+
+int main() {
+    testBasics();
+    testRandomAgainstMap();
+    testEraseIf();
+    return 0;
+}
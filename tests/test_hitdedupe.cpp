@@ -0,0 +1,95 @@
+#include "check.hpp"
+#include "hitdedupe.hpp"
+
+using bhh_events::HitDedupe;
+using Clock = HitDedupe::Clock;
+
+namespace {
+    constexpr RE::FormID target = 0xFF000810;
+    constexpr RE::FormID fist = 0x1F4;
+    constexpr RE::FormID enchantment = 0x0010F9A2;
+
+    Clock::time_point at(int ms) { return Clock::time_point{} + std::chrono::milliseconds(ms); }
+
+    void testFixedWindow() {
+        HitDedupe dedupe;
+        dedupe.Configure(100ms, false);
+        // One punch raising a burst of events, the enchantment hit is its own source.
+        CHECK(!dedupe.IsDuplicate(target, fist, at(0)));
+        CHECK(!dedupe.IsDuplicate(target, enchantment, at(1)));
+        CHECK(dedupe.IsDuplicate(target, fist, at(2)));
+        CHECK(dedupe.IsDuplicate(target, enchantment, at(3)));
+        CHECK(dedupe.IsDuplicate(target, fist, at(90)));
+        // The window runs from the first hit, duplicates don't extend it.
+        CHECK(!dedupe.IsDuplicate(target, fist, at(100)));
+        CHECK(dedupe.IsDuplicate(target, fist, at(150)));
+        CHECK(dedupe.Passed() == 3);
+        CHECK(dedupe.Dropped() == 4);
+    }
+
+    void testSlidingWindow() {
+        HitDedupe dedupe;
+        dedupe.Configure(100ms, true);
+        CHECK(!dedupe.IsDuplicate(target, fist, at(0)));
+        CHECK(dedupe.IsDuplicate(target, fist, at(90)));
+        // Each duplicate restarts the window.
+        CHECK(dedupe.IsDuplicate(target, fist, at(180)));
+        CHECK(dedupe.IsDuplicate(target, fist, at(270)));
+        CHECK(!dedupe.IsDuplicate(target, fist, at(370)));
+        CHECK(dedupe.Passed() == 2);
+        CHECK(dedupe.Dropped() == 3);
+    }
+
+    void testWindowZero() {
+        HitDedupe dedupe;
+        dedupe.Configure(0ms, false);
+        for (int i = 0; i < 10; ++i) {
+            CHECK(!dedupe.IsDuplicate(target, fist, at(0)));
+        }
+        CHECK(dedupe.Passed() == 10);
+        CHECK(dedupe.Dropped() == 0);
+    }
+
+    void testEvictsOldestWhenProbesLive() {
+        // Find more targets than probes that all start at the same slot.
+        std::vector<RE::FormID> colliding;
+        auto home = HitDedupe::HomeSlot(target, fist);
+        for (RE::FormID id = target; colliding.size() < HitDedupe::maxProbe + 1; ++id) {
+            if (HitDedupe::HomeSlot(id, fist) == home) {
+                colliding.push_back(id);
+            }
+        }
+        HitDedupe dedupe;
+        dedupe.Configure(1000ms, false);
+        for (int i = 0; i < static_cast<int>(HitDedupe::maxProbe); ++i) {
+            CHECK(!dedupe.IsDuplicate(colliding[i], fist, at(i)));
+        }
+        // Every probed slot is live, the newcomer takes the one opened longest ago.
+        CHECK(!dedupe.IsDuplicate(colliding[HitDedupe::maxProbe], fist, at(20)));
+        for (std::size_t i = 1; i <= HitDedupe::maxProbe; ++i) {
+            CHECK(dedupe.IsDuplicate(colliding[i], fist, at(21)));
+        }
+        // So the first hit is forgotten and counts again.
+        CHECK(!dedupe.IsDuplicate(colliding[0], fist, at(22)));
+    }
+
+    void testReset() {
+        HitDedupe dedupe;
+        dedupe.Configure(100ms, false);
+        dedupe.IsDuplicate(target, fist, at(0));
+        dedupe.IsDuplicate(target, fist, at(1));
+        dedupe.Reset();
+        CHECK(dedupe.Passed() == 0);
+        CHECK(dedupe.Dropped() == 0);
+        CHECK(!dedupe.IsDuplicate(target, fist, at(2)));
+    }
+}
+
+int main() {
+    testFixedWindow();
+    testSlidingWindow();
+    testWindowZero();
+    testEvictsOldestWhenProbesLive();
+    testReset();
+    return 0;
+}
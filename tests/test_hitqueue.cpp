@@ -0,0 +1,85 @@
+#include "check.hpp"
+#include "hitqueue.hpp"
+
+using bhh_events::HitQueue;
+using Clock = HitQueue::Clock;
+
+namespace {
+    constexpr RE::FormID target = 0xFF000810;
+    constexpr RE::FormID fist = 0x1F4;
+
+    Clock::time_point at(int ms) { return Clock::time_point{} + std::chrono::milliseconds(ms); }
+
+    void testDedupe() {
+        HitQueue hits;
+        hits.Configure(100ms, false);
+        CHECK(!hits.IsDuplicate(target, fist, at(0)));
+        CHECK(hits.IsDuplicate(target, fist, at(50)));
+        CHECK(!hits.IsDuplicate(target, fist, at(100)));
+        // Forgets remembered hits along with the counts.
+        CHECK(hits.IsDuplicate(target, fist, at(150)));
+        hits.ResetSession();
+        CHECK(!hits.IsDuplicate(target, fist, at(160)));
+    }
+
+    void testQueueOrderAndTickets() {
+        HitQueue hits;
+        RE::Actor first, second;
+        auto tracker = bhh_lifecycle::WorkTracker::GetSingleton();
+        auto inFlight = tracker->InFlight();
+        CHECK(hits.Push(first.GetHandle(), nullptr));
+        CHECK(hits.Push(second.GetHandle(), nullptr));
+        CHECK(tracker->InFlight() == inFlight + 2);
+        {
+            auto job = hits.Pop();
+            CHECK(job.defender.get().get() == &first);
+            CHECK(job.ticket.IsCurrent());
+        }
+        CHECK(hits.Pop().defender.get().get() == &second);
+        // Each ticket gives its slot back once the worker is done with the job.
+        CHECK(tracker->InFlight() == inFlight);
+    }
+
+    void testFullQueueDrops() {
+        HitQueue hits;
+        RE::Actor defender;
+        for (std::size_t i = 0; i < HitQueue::size; ++i) {
+            CHECK(hits.Push(defender.GetHandle(), nullptr));
+        }
+        CHECK(!hits.Push(defender.GetHandle(), nullptr));
+        for (std::size_t i = 0; i < HitQueue::size; ++i) {
+            hits.Pop();
+        }
+        CHECK(hits.Push(defender.GetHandle(), nullptr));
+        hits.Pop();
+    }
+
+    void testWorkerWakes() {
+        HitQueue hits;
+        RE::Actor defender;
+        std::atomic<int> popped = 0;
+        std::thread worker([&hits, &popped]() {
+            for (int i = 0; i < 100; ++i) {
+                hits.Pop();
+                ++popped;
+            }
+        });
+        for (int i = 0; i < 100;) {
+            if (hits.Push(defender.GetHandle(), nullptr)) {
+                ++i;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        worker.join();
+        CHECK(popped == 100);
+    }
+}
+
+int main() {
+    testDedupe();
+    testQueueOrderAndTickets();
+    testFullQueueDrops();
+    testWorkerWakes();
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include "check.hpp"
+#include "lifecycle.hpp"
+
+using bhh_lifecycle::WorkTicket;
+using bhh_lifecycle::WorkTracker;
+
+namespace {
+    // Stands in for the skill globals, only written by work whose ticket is still current.
+    struct GameState {
+        std::mutex mtx;
+        std::vector<std::uint32_t> committedGenerations;
+
+        void Commit(const WorkTicket& ticket) {
+            std::lock_guard<std::mutex> guard(mtx);
+            if (ticket.IsCurrent()) {
+                committedGenerations.push_back(ticket.Generation());
+            }
+        }
+        std::size_t Count() {
+            std::lock_guard<std::mutex> guard(mtx);
+            return committedGenerations.size();
+        }
+    };
+
+    // Like the VM waits, checks the ticket between slices of a wait that never gets answered.
+    void waitOnVM(WorkTicket ticket, GameState& state, std::atomic<int>& waiting) {
+        ++waiting;
+        while (ticket.IsCurrent()) {
+            std::this_thread::sleep_for(5ms);
+        }
+        state.Commit(ticket);
+    }
+
+    void testLoadMidCombat() {
+        auto tracker = WorkTracker::GetSingleton();
+        GameState state;
+
+        // Hits finished before the load keep their results.
+        {
+            auto ticket = tracker->Begin();
+            state.Commit(ticket);
+        }
+        CHECK(state.Count() == 1);
+
+        // A flurry of hits still waiting on the VM when the load starts.
+        std::atomic<int> waiting = 0;
+        std::vector<std::thread> workers;
+        for (int i = 0; i < 6; ++i) {
+            workers.emplace_back(waitOnVM, tracker->Begin(), std::ref(state), std::ref(waiting));
+        }
+        while (waiting < 6) {
+            std::this_thread::yield();
+        }
+        CHECK(tracker->InFlight() == 6);
+        auto oldGeneration = state.committedGenerations[0];
+
+        auto took = tracker->Drain();
+        CHECK(took < WorkTracker::defaultDrainDeadline);
+        CHECK(tracker->InFlight() == 0);
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        // None of the interrupted hits wrote anything.
+        CHECK(state.Count() == 1);
+
+        // Work started after the load belongs to the new game.
+        auto ticket = tracker->Begin();
+        CHECK(ticket.IsCurrent());
+        CHECK(ticket.Generation() != oldGeneration);
+        state.Commit(ticket);
+        CHECK(state.Count() == 2);
+    }
+
+    void testDeadlineHolds() {
+        auto tracker = WorkTracker::GetSingleton();
+        GameState state;
+        std::atomic<bool> started = false;
+        // A job that doesn't check its ticket while it runs, say a slow perk entry point.
+        std::thread stuck([&state, &started, ticket = tracker->Begin()]() {
+            started = true;
+            std::this_thread::sleep_for(600ms);
+            state.Commit(ticket);
+        });
+        while (!started) {
+            std::this_thread::yield();
+        }
+        auto took = tracker->Drain(50ms);
+        CHECK(took >= 50ms);
+        CHECK(took < 300ms);
+        CHECK(tracker->InFlight() == 1);
+        stuck.join();
+        // It finished late, but still dropped its stale result.
+        CHECK(state.Count() == 0);
+        CHECK(tracker->InFlight() == 0);
+    }
+
+    void testMovedTicket() {
+        auto tracker = WorkTracker::GetSingleton();
+        {
+            auto ticket = tracker->Begin();
+            WorkTicket moved(std::move(ticket));
+            CHECK(moved.IsCurrent());
+            CHECK(!ticket.IsCurrent());
+            CHECK(tracker->InFlight() == 1);
+        }
+        CHECK(tracker->InFlight() == 0);
+    }
+}
+
+int main() {
+    testLoadMidCombat();
+    testDeadlineHolds();
+    testMovedTicket();
+    return 0;
+}
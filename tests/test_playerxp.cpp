@@ -0,0 +1,98 @@
+#include "check.hpp"
+#include "playerxp.hpp"
+
+using namespace h2h_level;
+
+namespace {
+    class FakeStore : public PlayerXPStore {
+    public:
+        std::optional<PlayerXP> Read() override {
+            ++reads;
+            if (!readable) {
+                return std::nullopt;
+            }
+            return value;
+        }
+        bool Write(float xp) override {
+            ++writes;
+            if (writable) {
+                value.xp = xp;
+            }
+            return writable;
+        }
+
+        PlayerXP value;
+        bool readable = true;
+        bool writable = true;
+        int reads = 0;
+        int writes = 0;
+    };
+
+    void testAddAndThreshold() {
+        CHECK(addPlayerXP({100.0f, 300.0f}, 50.0f).xp == 150.0f);
+        CHECK(addPlayerXP({100.0f, 300.0f}, 50.0f).levelThreshold == 300.0f);
+        CHECK(addPlayerXP({10.0f, 300.0f}, -50.0f).xp == 0.0f);
+        // Experience keeps piling up past the threshold.
+        CHECK(addPlayerXP({350.0f, 300.0f}, 50.0f).xp == 400.0f);
+
+        CHECK(!canLevelUp({299.0f, 300.0f}));
+        CHECK(canLevelUp({300.0f, 300.0f}));
+        // An unknown threshold never claims a level up.
+        CHECK(!canLevelUp({300.0f, 0.0f}));
+
+        CHECK(!crossesLevelThreshold({100.0f, 300.0f}, 50.0f));
+        CHECK(crossesLevelThreshold({280.0f, 300.0f}, 20.0f));
+        // Only the grant that fills the bar crosses, later ones don't.
+        CHECK(!crossesLevelThreshold({310.0f, 300.0f}, 20.0f));
+        CHECK(!crossesLevelThreshold({280.0f, 0.0f}, 20.0f));
+    }
+
+    void testGrant() {
+        FakeStore store;
+        store.value = {100.0f, 300.0f};
+        CHECK(GrantPlayerXP(store, 25.0f));
+        CHECK(store.value.xp == 125.0f);
+
+        // A failed read writes nothing rather than adding onto a bogus value.
+        store.readable = false;
+        CHECK(!GrantPlayerXP(store, 25.0f));
+        CHECK(store.writes == 1);
+        CHECK(store.value.xp == 125.0f);
+
+        store.readable = true;
+        store.writable = false;
+        CHECK(!GrantPlayerXP(store, 25.0f));
+        CHECK(store.value.xp == 125.0f);
+    }
+
+    void testLevelUpRoute() {
+        FakeStore store, levelUpStore;
+        store.value = {250.0f, 300.0f};
+        CHECK(GrantPlayerXP(store, levelUpStore, 25.0f));
+        CHECK(store.value.xp == 275.0f);
+        CHECK(levelUpStore.writes == 0);
+
+        // The grant that fills the bar goes the other way, only read from the first store.
+        CHECK(GrantPlayerXP(store, levelUpStore, 25.0f));
+        CHECK(store.writes == 1);
+        CHECK(levelUpStore.reads == 0);
+        CHECK(levelUpStore.value.xp == 300.0f);
+
+        // Past the threshold it's back to the first store.
+        store.value.xp = 300.0f;
+        CHECK(GrantPlayerXP(store, levelUpStore, 25.0f));
+        CHECK(store.value.xp == 325.0f);
+        CHECK(levelUpStore.writes == 1);
+
+        levelUpStore.writable = false;
+        store.value.xp = 290.0f;
+        CHECK(!GrantPlayerXP(store, levelUpStore, 25.0f));
+    }
+}
+
+int main() {
+    testAddAndThreshold();
+    testGrant();
+    testLevelUpRoute();
+    return 0;
+}
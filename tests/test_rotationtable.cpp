@@ -0,0 +1,89 @@
+#include "check.hpp"
+#include "rotation.hpp"
+#include "rotationtable.hpp"
+
+using bhh_events::attackEvents;
+using bhh_events::RotationTable;
+using Clock = RotationTable::Clock;
+
+namespace {
+    constexpr RE::FormID npc = 0xFF000810;
+
+    Clock::time_point at(int ms) { return Clock::time_point{} + std::chrono::milliseconds(ms); }
+
+    void testToggleAndDebounce() {
+        RotationTable actors;
+        RE::Actor actor;
+        CHECK(!actors.WantsEvent(npc, at(1000)));
+        CHECK(actors.Track(npc, actor.GetHandle(), &actor));
+        CHECK(actors.WantsEvent(npc, at(1000)));
+        // Right hand attack, turned left for the next one.
+        CHECK(actors.Toggle(npc, "attackStop", attackEvents.rightAttack, false, at(1000)) == -1.0f);
+        // A second graph for the same actor within the window is ignored.
+        CHECK(!actors.WantsEvent(npc, at(1100)));
+        CHECK(actors.Toggle(npc, "attackStop", attackEvents.leftAttack, false, at(1100)) == 0.0f);
+        CHECK(actors.WantsEvent(npc, at(1400)));
+        CHECK(actors.Toggle(npc, "AttackWinStartLeft", attackEvents.leftAttack, false, at(1400)) == 1.0f);
+
+        // Leaving hands back the entry, saying there is a rotation to undo.
+        auto dropped = actors.Untrack(npc);
+        CHECK(dropped && dropped->toggled && dropped->rotation == 1.0f);
+        CHECK(!actors.IsTracked(npc));
+        CHECK(!actors.Untrack(npc));
+    }
+
+    void testIgnoredEvents() {
+        RotationTable actors;
+        RE::Actor actor;
+        actors.Track(npc, actor.GetHandle(), &actor);
+        // Not a rotation tag, doesn't start the debounce window.
+        CHECK(actors.Toggle(npc, "preHitFrame", attackEvents.rightAttack, false, at(1000)) == 0.0f);
+        CHECK(actors.WantsEvent(npc, at(1000)));
+        CHECK(actors.Toggle(npc, "attackStop", attackEvents.comboPowerAttack, true, at(1000)) == 0.0f);
+        // Not a hand to hand attack, still counts as the toggle for this window.
+        CHECK(actors.Toggle(npc, "attackStop", "AttackStartSword", false, at(1000)) == 0.0f);
+        CHECK(!actors.WantsEvent(npc, at(1000)));
+        // Nothing was applied, so there is nothing to undo.
+        CHECK(actors.IsTracked(npc));
+        CHECK(!actors.Untrack(npc)->toggled);
+        // Untracked actors never toggle.
+        CHECK(actors.Toggle(npc + 1, "attackStop", attackEvents.rightAttack, false, at(1000)) == 0.0f);
+    }
+
+    void testTrackingAndEviction() {
+        RotationTable actors;
+        RE::Actor gone, fighting;
+        gone.loaded = false;
+        CHECK(actors.Track(npc, gone.GetHandle(), &gone));
+        CHECK(actors.Track(npc + 1, fighting.GetHandle(), &fighting));
+        CHECK(actors.Size() == 2);
+        std::vector<const RE::Actor*> evicted;
+        auto count = actors.EraseIf([&evicted](RE::FormID, RotationTable::Entry& entry) {
+            if (entry.handle.get()) {
+                return false;
+            }
+            evicted.push_back(entry.graphSource);
+            return true;
+        });
+        CHECK(count == 1);
+        CHECK(evicted.size() == 1 && evicted[0] == &gone);
+        CHECK(!actors.WantsEvent(npc, at(1000)));
+        CHECK(actors.Untrack(npc + 1));
+        CHECK(!actors.Untrack(npc + 1));
+        CHECK(actors.Size() == 0);
+
+        for (RE::FormID i = 0; i < RotationTable::size; ++i) {
+            actors.Track(npc + i, fighting.GetHandle(), &fighting);
+        }
+        CHECK(!actors.Track(npc + RotationTable::size, fighting.GetHandle(), &fighting));
+        actors.Clear();
+        CHECK(actors.Size() == 0);
+    }
+}
+
+int main() {
+    testToggleAndDebounce();
+    testIgnoredEvents();
+    testTrackingAndEviction();
+    return 0;
+}
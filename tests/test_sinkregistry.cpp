@@ -0,0 +1,114 @@
+#include "check.hpp"
+#include "sinkregistry.hpp"
+
+using bhh_events::SinkRegistry;
+
+namespace {
+    struct MenuEvent {};
+
+    template <class Event>
+    class CountingSink : public RE::BSTEventSink<Event> {
+    public:
+        RE::BSEventNotifyControl ProcessEvent(const Event*, RE::BSTEventSource<Event>*) override {
+            SinkRegistry::GetSingleton()->RecordDispatch(this);
+            ++received;
+            return RE::BSEventNotifyControl::kContinue;
+        }
+        int received = 0;
+    };
+
+    CountingSink<MenuEvent> menuSink;
+    CountingSink<RE::BSAnimationGraphEvent> animSink;
+    RE::BSTEventSource<MenuEvent> menuSource;
+    RE::Actor player;
+    RE::Actor npc;
+
+    void testAttachIsIdempotent() {
+        auto registry = SinkRegistry::GetSingleton();
+        CHECK(registry->Attach("MenuSink", &menuSink, &menuSource, false));
+        CHECK(registry->Attach("MenuSink", &menuSink, &menuSource, false));
+        CHECK(menuSource.SinkCount() == 1);
+
+        MenuEvent event;
+        menuSource.SendEvent(&event);
+        CHECK(menuSink.received == 1);
+        CHECK(registry->DispatchCount(&menuSink) == 1);
+
+        CHECK(!registry->Attach<MenuEvent>("MenuSink", &menuSink, nullptr, false));
+    }
+
+    void testDetachSessionKeepsPersistent() {
+        auto registry = SinkRegistry::GetSingleton();
+        CHECK(registry->AttachAnimationGraph("AnimSink", &animSink, &player, true));
+        CHECK(registry->AttachAnimationGraph("AnimSink", &animSink, &player, true));
+        CHECK(player.graph.SinkCount() == 1);
+
+        registry->DetachSession();
+        CHECK(player.graph.SinkCount() == 0);
+        CHECK(menuSource.SinkCount() == 1);
+    }
+
+    void testReattachCountsOnce() {
+        auto registry = SinkRegistry::GetSingleton();
+        // Loads attach again, a second load must not double up dispatches.
+        for (int load = 0; load < 3; ++load) {
+            CHECK(registry->AttachAnimationGraph("AnimSink", &animSink, &player, true));
+            RE::BSAnimationGraphEvent event;
+            player.graph.SendEvent(&event);
+            registry->DetachSession();
+        }
+        CHECK(animSink.received == 3);
+        CHECK(registry->DispatchCount(&animSink) == 3);
+
+        CHECK(registry->AttachAnimationGraph("AnimSink", &animSink, &player, true));
+        CHECK(registry->AttachAnimationGraph("AnimSink", &animSink, &player, true));
+        RE::BSAnimationGraphEvent event;
+        player.graph.SendEvent(&event);
+        CHECK(registry->DispatchCount(&animSink) == 4);
+    }
+
+    void testDetachOneSource() {
+        auto registry = SinkRegistry::GetSingleton();
+        CHECK(registry->AttachAnimationGraph("AnimSink", &animSink, &npc, false));
+        CHECK(npc.graph.SinkCount() == 1);
+        registry->Detach(&animSink, &npc);
+        CHECK(npc.graph.SinkCount() == 0);
+        CHECK(player.graph.SinkCount() == 1);
+    }
+
+    void testUnloadedActor() {
+        auto registry = SinkRegistry::GetSingleton();
+        CHECK(registry->AttachAnimationGraph("AnimSink", &animSink, &npc, true));
+        // The remove goes through the handle, an unloaded actor is skipped rather than touched.
+        npc.loaded = false;
+        registry->DetachSession();
+        CHECK(npc.graph.SinkCount() == 1);
+        CHECK(player.graph.SinkCount() == 0);
+        npc.loaded = true;
+        // The record is gone, so it can attach again after it reloads.
+        npc.RemoveAnimationGraphEventSink(&animSink);
+        CHECK(registry->AttachAnimationGraph("AnimSink", &animSink, &npc, true));
+        CHECK(npc.graph.SinkCount() == 1);
+    }
+
+    void testDetachEverywhere() {
+        auto registry = SinkRegistry::GetSingleton();
+        CHECK(registry->AttachAnimationGraph("AnimSink", &animSink, &player, false));
+        registry->Detach(&animSink);
+        CHECK(player.graph.SinkCount() == 0);
+        CHECK(npc.graph.SinkCount() == 0);
+        CHECK(menuSource.SinkCount() == 1);
+        registry->Detach(&menuSink);
+        CHECK(menuSource.SinkCount() == 0);
+    }
+}
+
+int main() {
+    testAttachIsIdempotent();
+    testDetachSessionKeepsPersistent();
+    testReattachCountsOnce();
+    testDetachOneSource();
+    testUnloadedActor();
+    testDetachEverywhere();
+    return 0;
+}
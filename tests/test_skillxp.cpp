@@ -0,0 +1,91 @@
+#include "check.hpp"
+#include "skillxp.hpp"
+
+using namespace h2h_level;
+
+namespace {
+    void testFormulas() {
+        // Defaults: 2 * level^curve + 0 to level, 6.6 * damage^0.91 + 1 per hit.
+        CHECK_NEAR(nextSkillLevelXP(10.0f, 1.95f), 2.0 * std::pow(10.0, 1.95), 1e-2);
+        CHECK_NEAR(calcSkillXpGain(20.0f), 6.6 * std::pow(20.0, 0.91) + 1.0, 1e-3);
+        CHECK_NEAR(calcSkillXpGain(0.0f), 1.0, 1e-6);
+    }
+
+    void testAddSkillXP() {
+        auto need15 = nextSkillLevelXP(15.0f, 1.95f);
+        auto need16 = nextSkillLevelXP(16.0f, 1.95f);
+
+        auto none = addSkillXP(15.0f, 10.0f, 5.0f, 1.95f);
+        CHECK(none.levelsGained == 0);
+        CHECK(none.level == 15.0f);
+        CHECK_NEAR(none.exp, 15.0, 1e-4);
+        CHECK_NEAR(none.ratio, 15.0 / need15, 1e-6);
+        CHECK(none.levelSum == 0.0f);
+
+        // Enough for two levels, the leftover carries into the third.
+        auto two = addSkillXP(15.0f, 0.0f, need15 + need16 + 3.0f, 1.95f);
+        CHECK(two.levelsGained == 2);
+        CHECK(two.level == 17.0f);
+        CHECK_NEAR(two.exp, 3.0, 1e-2);
+        CHECK(two.levelSum == 16.0f + 17.0f);
+
+        // Stops at max level with nothing left over.
+        auto maxed = addSkillXP(Settings.SkillMaxLevel - 1.0f, 0.0f, 1e9f, 1.95f);
+        CHECK(maxed.level == Settings.SkillMaxLevel);
+        CHECK(maxed.levelsGained == 1);
+        CHECK(maxed.exp == 0.0f);
+        CHECK(maxed.ratio == 0.0f);
+    }
+
+    void testSnapshot() {
+        auto state = MakeSkillState(25.0f, 40.0f, 0.3f, 24.0f, 1.95f);
+        CHECK(state.level == 25.0f);
+        CHECK(state.exp == 40.0f);
+        CHECK(state.ratio == 0.3f);
+        CHECK(state.showLevelUp == 24.0f);
+        CHECK(state.xpNeeded == nextSkillLevelXP(25.0f, 1.95f));
+
+        // Nothing left to earn at max level.
+        auto maxed = MakeSkillState(Settings.SkillMaxLevel, 0.0f, 0.0f, Settings.SkillMaxLevel, 1.95f);
+        CHECK(maxed.xpNeeded == 0.0f);
+    }
+
+    void testArrayLayout() {
+        SkillState state{1.0f, 2.0f, 3.0f, 4.0f, 5.0f};
+        auto values = SkillStateToArray(state);
+        CHECK(values.size() == 5);
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            CHECK(values[i] == static_cast<float>(i + 1));
+        }
+    }
+
+    void testSettingsShared() {
+        // Loaded values have to reach every file using the settings, not a per file copy.
+        auto old = Settings.SkillImproveMult.value;
+        Settings.SkillImproveMult.value = 3.0f;
+        CHECK_NEAR(nextSkillLevelXP(2.0f, 1.0f), 6.0, 1e-6);
+        Settings.SkillImproveMult.value = old;
+    }
+
+    void testParseFormID() {
+        CHECK(ParseFormID("0x000D62") == 0xD62);
+        CHECK(ParseFormID("0XABCDEF") == 0xABCDEF);
+        CHECK(ParseFormID("") == 0);
+        // Without the prefix it would be ambiguous, so it's refused rather than read as decimal or hex.
+        CHECK(ParseFormID("000D62") == 0);
+        CHECK(ParseFormID("1234") == 0);
+        CHECK(ParseFormID("0x") == 0);
+        CHECK(ParseFormID("0x12G4") == 0);
+        CHECK(ParseFormID("0x100000000") == 0);
+    }
+}
+
+int main() {
+    testFormulas();
+    testAddSkillXP();
+    testSnapshot();
+    testArrayLayout();
+    testSettingsShared();
+    testParseFormID();
+    return 0;
+}
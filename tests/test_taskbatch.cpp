@@ -0,0 +1,72 @@
+#include "check.hpp"
+#include "taskbatch.hpp"
+
+using Batch = bhh_events::TaskBatch<int, 4>;
+using PushResult = Batch::PushResult;
+
+namespace {
+    void testOneDrainPerBurst() {
+        Batch batch;
+        CHECK(batch.Push(1) == PushResult::kScheduleDrain);
+        CHECK(batch.Push(2) == PushResult::kQueued);
+        CHECK(batch.Push(3) == PushResult::kQueued);
+        CHECK(batch.Push(4) == PushResult::kQueued);
+        CHECK(batch.Push(5) == PushResult::kFull);
+
+        std::vector<int> seen;
+        batch.Drain([&seen](int& item) { seen.push_back(item); });
+        CHECK((seen == std::vector<int>{1, 2, 3, 4}));
+        // Drained, the next push needs a new drain.
+        CHECK(batch.Push(6) == PushResult::kScheduleDrain);
+    }
+
+    void testPushDuringDrain() {
+        Batch batch;
+        batch.Push(1);
+        std::vector<int> seen;
+        batch.Drain([&](int& item) {
+            seen.push_back(item);
+            if (item < 3) {
+                // Already covered by the running drain.
+                CHECK(batch.Push(item + 1) == PushResult::kQueued);
+            }
+        });
+        CHECK((seen == std::vector<int>{1, 2, 3}));
+        CHECK(batch.Push(4) == PushResult::kScheduleDrain);
+    }
+
+    void testProducers() {
+        Batch batch;
+        std::atomic<int> drained = 0, dropped = 0;
+        std::vector<std::thread> producers;
+        for (int p = 0; p < 4; ++p) {
+            producers.emplace_back([&]() {
+                for (int i = 0; i < 1000; ++i) {
+                    switch (batch.Push(i)) {
+                    case PushResult::kScheduleDrain:
+                        batch.Drain([&drained](int&) { ++drained; });
+                        break;
+                    case PushResult::kFull:
+                        ++dropped;
+                        break;
+                    case PushResult::kQueued:
+                        break;
+                    }
+                }
+            });
+        }
+        for (auto& producer : producers) {
+            producer.join();
+        }
+        // Nothing is left stranded without a drain coming for it.
+        CHECK(drained + dropped == 4000);
+        CHECK(batch.Push(0) == PushResult::kScheduleDrain);
+    }
+}
+
+int main() {
+    testOneDrainPerBurst();
+    testPushDuringDrain();
+    testProducers();
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include "check.hpp"
+#include "xpdecay.hpp"
+
+using h2h_level::DiminishingReturns;
+using Clock = DiminishingReturns::Clock;
+
+namespace {
+    const Clock::time_point start{};
+
+    Clock::time_point at(double seconds) {
+        return start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+    }
+
+    void testPenaltyPerHit() {
+        DiminishingReturns dr;
+        dr.Configure(64, 30.0f, 0.05f, 0.25f);
+        // Fatigue 0, 1, 2, 3 without any time passing.
+        for (int hit = 0; hit < 4; ++hit) {
+            CHECK_NEAR(dr.RecordHit(0x14, start), std::pow(0.95, hit), 1e-5);
+        }
+        // Other defenders are tracked separately.
+        CHECK(dr.RecordHit(0x15, start) == 1.0f);
+    }
+
+    void testClampedAtMin() {
+        DiminishingReturns dr;
+        dr.Configure(64, 30.0f, 0.5f, 0.25f);
+        CHECK_NEAR(dr.RecordHit(0x14, start), 1.0, 1e-6);
+        CHECK_NEAR(dr.RecordHit(0x14, start), 0.5, 1e-6);
+        CHECK_NEAR(dr.RecordHit(0x14, start), 0.25, 1e-6);
+        // 0.125 unclamped.
+        CHECK_NEAR(dr.RecordHit(0x14, start), 0.25, 1e-6);
+    }
+
+    void testHalfLife() {
+        DiminishingReturns dr;
+        dr.Configure(64, 10.0f, 0.1f, 0.0f);
+        dr.RecordHit(0x14, at(0));
+        dr.RecordHit(0x14, at(0));
+        // Fatigue 2 halves to 1 after one half life.
+        CHECK_NEAR(dr.RecordHit(0x14, at(10)), 0.9, 1e-5);
+        // Now fatigue 2 again, two half lives leaves 0.5.
+        CHECK_NEAR(dr.RecordHit(0x14, at(30)), std::pow(0.9, 0.5), 1e-5);
+        // Long enough later it's all but forgotten.
+        CHECK_NEAR(dr.RecordHit(0x14, at(1000)), 1.0, 1e-5);
+    }
+
+    void testDisabled() {
+        DiminishingReturns dr;
+        dr.Configure(0, 30.0f, 0.05f, 0.25f);
+        CHECK(dr.Capacity() == 0);
+        CHECK(dr.RecordHit(0x14, start) == 1.0f);
+        CHECK(dr.RecordHit(0x14, start) == 1.0f);
+        dr.Configure(64, 30.0f, 0.0f, 0.25f);
+        CHECK(dr.Capacity() == 0);
+        CHECK(dr.RecordHit(0x14, start) == 1.0f);
+        // FormID 0 marks an empty way, it's never tracked.
+        dr.Configure(64, 30.0f, 0.05f, 0.25f);
+        dr.RecordHit(0, start);
+        CHECK(dr.RecordHit(0, start) == 1.0f);
+    }
+
+    void testEvictsLeastRecent() {
+        DiminishingReturns dr;
+        // A single set, every defender competes for the same ways.
+        dr.Configure(DiminishingReturns::ways, 30.0f, 0.5f, 0.0f);
+        CHECK(dr.Capacity() == DiminishingReturns::ways);
+        for (RE::FormID id = 1; id <= DiminishingReturns::ways; ++id) {
+            dr.RecordHit(id, at(id));
+        }
+        CHECK(dr.Evictions() == 0);
+        // Defender 1 is the least recently hit, a new defender takes its way.
+        dr.RecordHit(100, at(20));
+        CHECK(dr.Evictions() == 1);
+        CHECK(dr.RecordHit(2, at(20)) < 1.0f);
+        CHECK(dr.RecordHit(1, at(20)) == 1.0f);
+        CHECK(dr.Evictions() == 2);
+
+        dr.Clear();
+        CHECK(dr.Evictions() == 0);
+        CHECK(dr.RecordHit(2, at(20)) == 1.0f);
+    }
+}
+
+int main() {
+    testPenaltyPerHit();
+    testClampedAtMin();
+    testHalfLife();
+    testDisabled();
+    testEvictsLeastRecent();
+    return 0;
+}